@@ -0,0 +1,186 @@
+#include <stdlib.h>
+
+#include "kernel_bench.h"
+#include "match_game.h"
+#include "match_kernels.h"
+
+// match rules, scalar per player and batched per ball
+typedef struct
+{
+    int* speed;
+    int* kick;
+    int* goal;
+    int* outX;
+    int* outY;
+    int* flags;
+    rand_stream rng;
+} match_bench;
+
+// the field layout is the config, so this pass needs nothing from the fixture
+long getFieldProcessPass(bench_samples* samples, void* data)
+{
+    int p;
+    long sum = 0;
+    (void) data;
+    for (p = 0; p < samples->n; p++)
+    {
+        pos at = {samples->x[p], samples->y[p]};
+        sum += getFieldProcess(at);
+    }
+    return sum;
+}
+
+long inBallFieldBatchPass(bench_samples* samples, void* data)
+{
+    int b;
+    match_bench* bench = data;
+    for (b = 0; b < samples->numBlocks; b++)
+    {
+        int first = samples->blockStart[b];
+        pos ball = {samples->ballX[first], samples->ballY[first]};
+        inBallFieldBatch(samples->blockStart[b + 1] - first, samples->x + first, samples->y + first, ball,
+            bench->flags + first);
+    }
+    return bench->flags[0] + bench->flags[samples->n - 1];
+}
+
+long isBallWithinRangePass(bench_samples* samples, void* data)
+{
+    int p;
+    long sum = 0;
+    match_bench* bench = data;
+    for (p = 0; p < samples->n; p++)
+    {
+        football_player player;
+        pos ball = {samples->ballX[p], samples->ballY[p]};
+        player.initial.x = samples->x[p];
+        player.initial.y = samples->y[p];
+        player.speed = bench->speed[p];
+        sum += isBallWithinRange(ball, player);
+    }
+    return sum;
+}
+
+long ballWithinRangeBatchPass(bench_samples* samples, void* data)
+{
+    int b;
+    match_bench* bench = data;
+    for (b = 0; b < samples->numBlocks; b++)
+    {
+        int first = samples->blockStart[b];
+        pos ball = {samples->ballX[first], samples->ballY[first]};
+        ballWithinRangeBatch(samples->blockStart[b + 1] - first, samples->x + first, samples->y + first,
+            bench->speed + first, ball, bench->flags + first);
+    }
+    return bench->flags[0] + bench->flags[samples->n - 1];
+}
+
+long tryToReachPass(bench_samples* samples, void* data)
+{
+    int p;
+    long sum = 0;
+    match_bench* bench = data;
+    for (p = 0; p < samples->n; p++)
+    {
+        football_player player;
+        pos ball = {samples->ballX[p], samples->ballY[p]};
+        player.initial.x = samples->x[p];
+        player.initial.y = samples->y[p];
+        player.speed = bench->speed[p];
+        tryToReach(ball, &player);
+        sum += player.final.x + player.final.y;
+    }
+    return sum;
+}
+
+long tryToReachBatchPass(bench_samples* samples, void* data)
+{
+    int b;
+    match_bench* bench = data;
+    for (b = 0; b < samples->numBlocks; b++)
+    {
+        int first = samples->blockStart[b];
+        tryToReachBatch(samples->blockStart[b + 1] - first, samples->x + first, samples->y + first,
+            samples->ballX + first, samples->ballY + first, bench->speed + first, bench->outX + first, bench->outY + first);
+    }
+    return bench->outX[0] + bench->outY[samples->n - 1];
+}
+
+long aimBallPass(bench_samples* samples, void* data)
+{
+    int p;
+    long sum = 0;
+    match_bench* bench = data;
+    for (p = 0; p < samples->n; p++)
+    {
+        football_player player;
+        pos target;
+        player.final.x = samples->x[p];
+        player.final.y = samples->y[p];
+        player.kick = bench->kick[p];
+        aimBall(&target, player, bench->goal[p], &bench->rng);
+        sum += target.x + target.y;
+    }
+    return sum;
+}
+
+long aimAtGoalBatchPass(bench_samples* samples, void* data)
+{
+    match_bench* bench = data;
+    aimAtGoalBatch(samples->n, samples->x, samples->y, bench->kick, bench->goal, bench->outX, bench->outY);
+    return bench->outX[0] + bench->outY[samples->n - 1];
+}
+
+void benchMatchSamples(bench_samples* samples)
+{
+    int p;
+    match_bench bench;
+    int n = samples->n;
+
+    bench.speed = malloc(n * sizeof(int));
+    bench.kick = malloc(n * sizeof(int));
+    bench.goal = malloc(n * sizeof(int));
+    bench.outX = malloc(n * sizeof(int));
+    bench.outY = malloc(n * sizeof(int));
+    bench.flags = malloc(n * sizeof(int));
+    seedRandom(&bench.rng, 0);
+    for (p = 0; p < n; p++)
+    {
+        // the attributes initPlayers gives every player
+        bench.speed[p] = 10;
+        bench.kick[p] = 4;
+        bench.goal[p] = (p % 2) ? RIGHT_GOAL : LEFT_GOAL;
+    }
+
+    benchRun("getFieldProcess", samples, getFieldProcessPass, &bench);
+    benchRun("inBallFieldBatch", samples, inBallFieldBatchPass, &bench);
+    benchRun("isBallWithinRange", samples, isBallWithinRangePass, &bench);
+    benchRun("ballWithinRangeBatch", samples, ballWithinRangeBatchPass, &bench);
+    benchRun("tryToReach", samples, tryToReachPass, &bench);
+    benchRun("tryToReachBatch", samples, tryToReachBatchPass, &bench);
+    benchRun("aimBall", samples, aimBallPass, &bench);
+    benchRun("aimAtGoalBatch", samples, aimAtGoalBatchPass, &bench);
+
+    free(bench.speed);
+    free(bench.kick);
+    free(bench.goal);
+    free(bench.outX);
+    free(bench.outY);
+    free(bench.flags);
+}
+
+void benchMatchKernels(int n, int block, bench_samples replays[], int numReplays)
+{
+    int r;
+    bench_samples samples;
+
+    makeUniformSamples(&samples, n, block, config.length, config.width);
+    benchMatchSamples(&samples);
+    freeSamples(&samples);
+
+    makeNearBallSamples(&samples, n, block, config.length, config.width);
+    benchMatchSamples(&samples);
+    freeSamples(&samples);
+
+    for (r = 0; r < numReplays; r++) benchMatchSamples(&replays[r]);
+}
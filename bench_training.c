@@ -0,0 +1,93 @@
+#include <stdlib.h>
+
+#include "kernel_bench.h"
+#include "training_game.h"
+
+// training rules, per block of players sharing a ball
+typedef struct
+{
+    football_player* players;
+    int* reached;
+    unsigned char* reached_set;
+    rand_stream rng;
+} training_bench;
+
+long movePlayersPass(bench_samples* samples, void* data)
+{
+    int b;
+    training_bench* bench = data;
+    for (b = 0; b < samples->numBlocks; b++)
+    {
+        int first = samples->blockStart[b];
+        pos ball = {samples->ballX[first], samples->ballY[first]};
+        move_players(bench->players + first, samples->blockStart[b + 1] - first, ball);
+    }
+    return bench->players[0].final.x + bench->players[samples->n - 1].final.y;
+}
+
+long determineKickerPass(bench_samples* samples, void* data)
+{
+    int b;
+    long sum = 0;
+    training_bench* bench = data;
+    for (b = 0; b < samples->numBlocks; b++)
+    {
+        int kicker, numReached = 0;
+        int first = samples->blockStart[b];
+        pos ball = {samples->ballX[first], samples->ballY[first]};
+        determine_kicker(&kicker, bench->reached, bench->reached_set, &numReached, samples->blockStart[b + 1] - first,
+            bench->players + first, ball, &bench->rng);
+        sum += kicker;
+    }
+    return sum;
+}
+
+void benchTrainingSamples(bench_samples* samples)
+{
+    int p, b, block = 0;
+    training_bench bench;
+    int n = samples->n;
+
+    for (b = 0; b < samples->numBlocks; b++)
+    {
+        int size = samples->blockStart[b + 1] - samples->blockStart[b];
+        if (size > block) block = size;
+    }
+    bench.players = malloc(n * sizeof(football_player));
+    bench.reached = malloc((block + 1) * sizeof(int));
+    bench.reached_set = malloc(block / 8 + 1);
+    seedRandom(&bench.rng, 0);
+    for (p = 0; p < n; p++)
+    {
+        bench.players[p].id = p;
+        bench.players[p].initial.x = bench.players[p].final.x = samples->x[p];
+        bench.players[p].initial.y = bench.players[p].final.y = samples->y[p];
+        bench.players[p].ran = 0;
+        bench.players[p].reached = 0;
+        bench.players[p].kicked = 0;
+    }
+
+    benchRun("move_players", samples, movePlayersPass, &bench);
+    // the kicker is picked among the positions the players just moved to
+    benchRun("determine_kicker", samples, determineKickerPass, &bench);
+
+    free(bench.players);
+    free(bench.reached);
+    free(bench.reached_set);
+}
+
+void benchTrainingKernels(int n, int block, bench_samples replays[], int numReplays)
+{
+    int r;
+    bench_samples samples;
+
+    makeUniformSamples(&samples, n, block, LENGTH, WIDTH);
+    benchTrainingSamples(&samples);
+    freeSamples(&samples);
+
+    makeNearBallSamples(&samples, n, block, LENGTH, WIDTH);
+    benchTrainingSamples(&samples);
+    freeSamples(&samples);
+
+    for (r = 0; r < numReplays; r++) benchTrainingSamples(&replays[r]);
+}
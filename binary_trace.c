@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "binary_trace.h"
+
+#define KEYFRAME 'K'
+#define DELTA 'D'
+#define MAX_VARINT 10       // bytes of a 64 bit varint
+
+// id, initial x y, final x y, reached, kicked, challenge
+const trace_layout matchLayout = {"match", 8,
+    {0, 3, 4, FROM_NOTHING, FROM_NOTHING, FROM_NOTHING, FROM_NOTHING, 7},
+    {FROM_NOTHING, FROM_NOTHING, FROM_NOTHING, 1, 2, FROM_NOTHING, FROM_NOTHING, FROM_NOTHING}};
+
+// id, initial x y, final x y, reached and kicked this round, ran, reached, kicked
+const trace_layout trainingLayout = {"training", 10,
+    {0, 3, 4, FROM_NOTHING, FROM_NOTHING, FROM_NOTHING, FROM_NOTHING, 7, 8, 9},
+    {FROM_NOTHING, FROM_NOTHING, FROM_NOTHING, 1, 2, FROM_NOTHING, FROM_NOTHING, FROM_NOTHING, FROM_NOTHING, FROM_NOTHING}};
+
+// the layout byte of a file indexes this
+static const trace_layout* layouts[] = {&matchLayout, &trainingLayout};
+
+static unsigned char* putVarint(unsigned char* at, unsigned long value)
+{
+    while (value >= 0x80)
+    {
+        *at++ = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    *at++ = (unsigned char) value;
+    return at;
+}
+
+static const unsigned char* getVarint(const unsigned char* at, const unsigned char* end, unsigned long* value)
+{
+    int shift = 0;
+    *value = 0;
+    while (at < end && shift < 64)
+    {
+        unsigned char byte = *at++;
+        *value |= (unsigned long) (byte & 0x7f) << shift;
+        if (byte < 0x80) return at;
+        shift += 7;
+    }
+    return NULL;
+}
+
+// returns the bytes it took, 0 if there was no varint
+static int readFileVarint(FILE* file, unsigned long* value)
+{
+    unsigned char bytes[MAX_VARINT];
+    int length = 0, c;
+    while (length < MAX_VARINT && (c = fgetc(file)) != EOF)
+    {
+        bytes[length++] = (unsigned char) c;
+        if (c < 0x80) return getVarint(bytes, bytes + length, value) != NULL ? length : 0;
+    }
+    return 0;
+}
+
+static unsigned long zigzag(long value)
+{
+    return ((unsigned long) value << 1) ^ (unsigned long) (value >> 63);
+}
+
+static long unzigzag(unsigned long value)
+{
+    return (long) (value >> 1) ^ -(long) (value & 1);
+}
+
+// what value i of a round is expected to be, given the values before it
+static int predict(binary_trace* trace, const int values[], int i, int keyframe)
+{
+    const trace_layout* layout = trace->layout;
+    int field = i % layout->fields;
+    int line = i - field;
+    if (layout->current[field] != FROM_NOTHING) return values[line + layout->current[field]];
+    if (layout->previous[field] != FROM_NOTHING && !keyframe) return trace->previous[line + layout->previous[field]];
+    return 0;
+}
+
+static void startTrace(binary_trace* trace, FILE* file, const trace_layout* layout, int numPlayers)
+{
+    trace->file = file;
+    trace->layout = layout;
+    trace->numPlayers = numPlayers;
+    trace->rounds = 0;
+    trace->offset = 0;
+    trace->previous = calloc(numPlayers * layout->fields, sizeof(int));
+    trace->bufferSize = 1 + (3 + (long) numPlayers * layout->fields) * MAX_VARINT;
+    trace->buffer = malloc(trace->bufferSize);
+}
+
+void openTraceWriter(binary_trace* trace, FILE* file, const trace_layout* layout, int numPlayers)
+{
+    unsigned char header[1 + MAX_VARINT];
+    unsigned char* at = header;
+    startTrace(trace, file, layout, numPlayers);
+    *at++ = (layout == &trainingLayout);
+    at = putVarint(at, numPlayers);
+    fwrite(BINARY_TRACE_MAGIC, 1, 8, file);
+    fwrite(header, 1, at - header, file);
+}
+
+void writeTraceRound(binary_trace* trace, int round, int ballX, int ballY, const int values[])
+{
+    int i, count = trace->numPlayers * trace->layout->fields;
+    int keyframe = (trace->rounds % KEYFRAME_INTERVAL == 0);
+    unsigned long zeros = 0;
+    unsigned char length[MAX_VARINT];
+    unsigned char* at = trace->buffer;
+
+    *at++ = keyframe ? KEYFRAME : DELTA;
+    at = putVarint(at, zigzag(keyframe ? round : (long) round - trace->round - 1));
+    at = putVarint(at, zigzag(keyframe ? ballX : (long) ballX - trace->ballX));
+    at = putVarint(at, zigzag(keyframe ? ballY : (long) ballY - trace->ballY));
+    for (i = 0; i < count; i++)
+    {
+        long residual = (long) values[i] - predict(trace, values, i, keyframe);
+        if (residual == 0)
+        {
+            zeros++;
+            continue;
+        }
+        // even tokens are differences, odd ones runs of zeros
+        if (zeros > 0) at = putVarint(at, (zeros - 1) << 1 | 1);
+        zeros = 0;
+        at = putVarint(at, zigzag(residual) << 1);
+    }
+    if (zeros > 0) at = putVarint(at, (zeros - 1) << 1 | 1);
+
+    fwrite(length, 1, putVarint(length, at - trace->buffer) - length, trace->file);
+    fwrite(trace->buffer, 1, at - trace->buffer, trace->file);
+    memcpy(trace->previous, values, count * sizeof(int));
+    trace->round = round;
+    trace->ballX = ballX;
+    trace->ballY = ballY;
+    trace->rounds++;
+}
+
+const char* openTraceReader(binary_trace* trace, FILE* file)
+{
+    char magic[8];
+    unsigned long numPlayers;
+    int layout, bytes;
+
+    if (fread(magic, 1, 8, file) != 8 || memcmp(magic, BINARY_TRACE_MAGIC, 8) != 0) return "not a binary trace";
+    layout = fgetc(file);
+    if (layout < 0 || layout > 1 || !(bytes = readFileVarint(file, &numPlayers)) || numPlayers > 1 << 24)
+    {
+        return "damaged trace header";
+    }
+    startTrace(trace, file, layouts[layout], (int) numPlayers);
+    trace->offset = 8 + 1 + bytes;
+    return NULL;
+}
+
+int readTraceRound(binary_trace* trace, int* round, int* ballX, int* ballY, int values[])
+{
+    int i = 0, count = trace->numPlayers * trace->layout->fields, bytes;
+    unsigned long length, token;
+    const unsigned char* at = trace->buffer;
+    const unsigned char* end;
+
+    if (!(bytes = readFileVarint(trace->file, &length))) return feof(trace->file) ? TRACE_END : TRACE_DAMAGED;
+    if (length < 1 || length > (unsigned long) trace->bufferSize) return TRACE_DAMAGED;
+    if (fread(trace->buffer, 1, length, trace->file) != length) return TRACE_DAMAGED;
+    end = at + length;
+
+    if (*at != KEYFRAME && *at != DELTA) return TRACE_DAMAGED;
+    int keyframe = (*at++ == KEYFRAME);
+    if ((at = getVarint(at, end, &token)) == NULL) return TRACE_DAMAGED;
+    *round = (int) (unzigzag(token) + (keyframe ? 0 : trace->round + 1));
+    if ((at = getVarint(at, end, &token)) == NULL) return TRACE_DAMAGED;
+    *ballX = (int) (unzigzag(token) + (keyframe ? 0 : trace->ballX));
+    if ((at = getVarint(at, end, &token)) == NULL) return TRACE_DAMAGED;
+    *ballY = (int) (unzigzag(token) + (keyframe ? 0 : trace->ballY));
+
+    while (i < count)
+    {
+        if ((at = getVarint(at, end, &token)) == NULL) return TRACE_DAMAGED;
+        if (token & 1)
+        {
+            unsigned long zeros = (token >> 1) + 1;
+            if (zeros > (unsigned long) (count - i)) return TRACE_DAMAGED;
+            while (zeros-- > 0) values[i] = predict(trace, values, i, keyframe), i++;
+        }
+        else
+        {
+            values[i] = (int) (predict(trace, values, i, keyframe) + unzigzag(token >> 1));
+            i++;
+        }
+    }
+    if (at != end) return TRACE_DAMAGED;
+
+    memcpy(trace->previous, values, count * sizeof(int));
+    trace->round = *round;
+    trace->ballX = *ballX;
+    trace->ballY = *ballY;
+    trace->rounds++;
+    trace->offset += bytes + length;
+    return TRACE_ROUND;
+}
+
+void closeTrace(binary_trace* trace)
+{
+    fflush(trace->file);
+    free(trace->previous);
+    free(trace->buffer);
+}
+
+void printTraceRound(FILE* file, const trace_layout* layout, int numPlayers, int round, int ballX, int ballY, const int values[])
+{
+    int i, p;
+    fprintf(file, "%d\n", round);
+    fprintf(file, "%d %d\n", ballX, ballY);
+    for (p = 0; p < numPlayers; p++)
+    {
+        for (i = 0; i < layout->fields; i++) fprintf(file, "%d ", values[p * layout->fields + i]);
+        fprintf(file, "\n");
+    }
+}
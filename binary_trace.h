@@ -0,0 +1,67 @@
+#ifndef BINARY_TRACE_H
+#define BINARY_TRACE_H
+
+#include <stdio.h>
+
+#define BINARY_TRACE_MAGIC "TRACEBN1"
+#define MAX_TRACE_FIELDS 10
+#define KEYFRAME_INTERVAL 256       // rounds, a reader can start at any keyframe
+#define FROM_NOTHING -1
+
+// results of readTraceRound
+#define TRACE_END 0
+#define TRACE_ROUND 1
+#define TRACE_DAMAGED -1
+
+// trace formats the simulators write on stdout
+#define OUTPUT_TEXT 0
+#define OUTPUT_BINARY 1     // trace_text prints it as text
+#define OUTPUT_NONE 2       // no trace, e.g. with only a summary
+
+// Binary traces hold the same ints as the text traces. Each int of a
+// player line is predicted from a field of the same player in the round
+// before or from an earlier field of its own line, and only the
+// difference is stored: zigzag varints, with runs of zeros as one varint.
+// Keyframes predict nothing from the round before.
+typedef struct
+{
+    const char* name;
+    int fields;                         // ints per player line
+    int previous[MAX_TRACE_FIELDS];     // field of the round before, or FROM_NOTHING
+    int current[MAX_TRACE_FIELDS];      // earlier field of this line, or FROM_NOTHING
+} trace_layout;
+
+extern const trace_layout matchLayout;      // lines of printPlayerInfo
+extern const trace_layout trainingLayout;   // lines of player_line
+
+// A file is the magic, the layout, the number of players and then one
+// record per round: its length, 'K' or 'D', the round and the ball, then
+// the player lines in print order.
+typedef struct
+{
+    FILE* file;
+    const trace_layout* layout;
+    int numPlayers;
+    long rounds;                // rounds so far, for the keyframes
+    long offset;                // bytes read up to the round being read
+    int round;                  // the round before
+    int ballX, ballY;
+    int* previous;              // its player lines
+    unsigned char* buffer;      // one encoded round
+    long bufferSize;
+} binary_trace;
+
+void openTraceWriter(binary_trace* trace, FILE* file, const trace_layout* layout, int numPlayers);
+void writeTraceRound(binary_trace* trace, int round, int ballX, int ballY, const int values[]);
+
+// returns why the file cannot be read or NULL
+const char* openTraceReader(binary_trace* trace, FILE* file);
+int readTraceRound(binary_trace* trace, int* round, int* ballX, int* ballY, int values[]);
+
+// flushes the writer, the file stays open
+void closeTrace(binary_trace* trace);
+
+// prints a round the way the text traces do
+void printTraceRound(FILE* file, const trace_layout* layout, int numPlayers, int round, int ballX, int ballY, const int values[]);
+
+#endif
@@ -0,0 +1,117 @@
+#include <stdio.h>
+
+#include "match_game.h"
+#include "trace_check.h"
+
+// a player line, see printPlayerInfo
+#define ID 0
+#define INITIAL_X 1
+#define INITIAL_Y 2
+#define FINAL_X 3
+#define FINAL_Y 4
+#define REACHED 5
+#define KICKED 6
+#define CHALLENGE 7
+#define MATCH_FIELDS 8
+
+void checkMatchRound(trace_round* prev, trace_round* cur, int numPlayers, trace_totals* totals);
+void printMatchStats(player_stats stats[], int numPlayers);
+
+trace_format matchTrace = {"match", MATCH_FIELDS, checkMatchRound, printMatchStats};
+
+static int onField(int x, int y)
+{
+    return x >= 0 && x < config.length && y >= 0 && y < config.width;
+}
+
+static int distance(int from, int to)
+{
+    return from < to ? to - from : from - to;
+}
+
+// Players move towards the ball the last round left behind, so reaching
+// and kicking are checked against that ball. The first half starts from
+// the kick-off spot; the second starts where the first left the ball.
+void checkMatchRound(trace_round* prev, trace_round* cur, int numPlayers, trace_totals* totals)
+{
+    int p, goalA, goalB;
+    int teamSize = numPlayers / 2;
+    int kicks = 0, kicker = NO_WINNER;
+    int topChallenge = 0, winner = NO_WINNER;
+    pos ball;
+
+    if (prev == NULL) initField(&goalA, &goalB, &ball);
+    else
+    {
+        ball.x = prev->ballX;
+        ball.y = prev->ballY;
+    }
+
+    totals->rounds++;
+    if (prev == NULL ? cur->round != 0 : cur->round != prev->round + 1 && cur->round != 0)
+    {
+        reportViolation(totals, cur, NO_PLAYER, "round out of order");
+    }
+    if (!onField(cur->ballX, cur->ballY)) reportViolation(totals, cur, NO_PLAYER, "ball off the field");
+
+    for (p = 0; p < numPlayers; p++)
+    {
+        int* player = &cur->values[p * MATCH_FIELDS];
+        int dx = distance(player[INITIAL_X], player[FINAL_X]);
+        int dy = distance(player[INITIAL_Y], player[FINAL_Y]);
+        int onBall = player[FINAL_X] == ball.x && player[FINAL_Y] == ball.y;
+
+        if (player[ID] != p % teamSize) reportViolation(totals, cur, p, "player out of order");
+        if (!onField(player[INITIAL_X], player[INITIAL_Y]) || !onField(player[FINAL_X], player[FINAL_Y]))
+        {
+            reportViolation(totals, cur, p, "player off the field");
+        }
+        if (dx > MAX_STEP || dy > MAX_STEP) reportViolation(totals, cur, p, "moved more than MAX_STEP along an axis");
+
+        // every half starts from the kick-off positions
+        if (prev != NULL && cur->round != 0)
+        {
+            int* before = &prev->values[p * MATCH_FIELDS];
+            if (player[INITIAL_X] != before[FINAL_X] || player[INITIAL_Y] != before[FINAL_Y])
+            {
+                reportViolation(totals, cur, p, "did not start where the last round ended");
+            }
+        }
+
+        if (player[REACHED] != onBall) reportViolation(totals, cur, p, "reached does not match the ball");
+        if (player[REACHED] ? player[CHALLENGE] < 1 : player[CHALLENGE] != -1)
+        {
+            reportViolation(totals, cur, p, "challenge does not match reached");
+        }
+        if (player[KICKED])
+        {
+            kicks++;
+            kicker = p;
+            if (!player[REACHED]) reportViolation(totals, cur, p, "kicked without reaching the ball");
+        }
+        if (player[REACHED] && player[CHALLENGE] > topChallenge)
+        {
+            topChallenge = player[CHALLENGE];
+            winner = p;
+        }
+
+        totals->stats[p].distance += dx + dy;
+        totals->stats[p].reached += player[REACHED];
+        totals->stats[p].kicked += player[KICKED];
+    }
+
+    // the first player with the strictly highest challenge kicks
+    if (kicks > 1) reportViolation(totals, cur, NO_PLAYER, "more than one kicker");
+    else if (kicker != winner) reportViolation(totals, cur, winner, "won the challenge but did not kick");
+}
+
+void printMatchStats(player_stats stats[], int numPlayers)
+{
+    int p;
+    printf("team player distance reached kicked\n");
+    for (p = 0; p < numPlayers; p++)
+    {
+        printf("%c %d %ld %ld %ld\n", p < numPlayers / 2 ? 'A' : 'B', p % (numPlayers / 2),
+            stats[p].distance, stats[p].reached, stats[p].kicked);
+    }
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+
+#include "training_game.h"
+#include "trace_check.h"
+
+// a player line, see player_line in training_game.c
+#define ID 0
+#define INITIAL_X 1
+#define INITIAL_Y 2
+#define FINAL_X 3
+#define FINAL_Y 4
+#define HAS_REACHED 5
+#define HAS_KICKED 6
+#define RAN 7
+#define REACHED 8
+#define KICKED 9
+#define TRAINING_FIELDS 10
+
+// a player runs at most this far in a round, see move_players
+#define MAX_RUN 10
+
+void checkTrainingRound(trace_round* prev, trace_round* cur, int numPlayers, trace_totals* totals);
+void printTrainingStats(player_stats stats[], int numPlayers);
+
+trace_format trainingTrace = {"training", TRAINING_FIELDS, checkTrainingRound, printTrainingStats};
+
+static int onField(int x, int y)
+{
+    return x >= 0 && x < LENGTH && y >= 0 && y < WIDTH;
+}
+
+static int distance(int from, int to)
+{
+    return from < to ? to - from : from - to;
+}
+
+// The ball of a round is where the players ran to, and the counters at
+// the end of each line add up that round's run, reach and kick
+void checkTrainingRound(trace_round* prev, trace_round* cur, int numPlayers, trace_totals* totals)
+{
+    int p;
+    int kicks = 0, reached = 0;
+
+    totals->rounds++;
+    if (cur->round != (prev == NULL ? 0 : prev->round + 1)) reportViolation(totals, cur, NO_PLAYER, "round out of order");
+    if (!onField(cur->ballX, cur->ballY)) reportViolation(totals, cur, NO_PLAYER, "ball off the field");
+
+    for (p = 0; p < numPlayers; p++)
+    {
+        int* player = &cur->values[p * TRAINING_FIELDS];
+        int* before = prev == NULL ? NULL : &prev->values[p * TRAINING_FIELDS];
+        int run = distance(player[INITIAL_X], player[FINAL_X]) + distance(player[INITIAL_Y], player[FINAL_Y]);
+        int onBall = player[FINAL_X] == cur->ballX && player[FINAL_Y] == cur->ballY;
+
+        if (player[ID] != p) reportViolation(totals, cur, p, "player out of order");
+        if (!onField(player[INITIAL_X], player[INITIAL_Y]) || !onField(player[FINAL_X], player[FINAL_Y]))
+        {
+            reportViolation(totals, cur, p, "player off the field");
+        }
+        if (run > MAX_RUN) reportViolation(totals, cur, p, "ran more than 10");
+        if (before != NULL && (player[INITIAL_X] != before[FINAL_X] || player[INITIAL_Y] != before[FINAL_Y]))
+        {
+            reportViolation(totals, cur, p, "did not start where the last round ended");
+        }
+
+        if (player[HAS_REACHED] != onBall) reportViolation(totals, cur, p, "reached does not match the ball");
+        if (player[HAS_KICKED] && !player[HAS_REACHED]) reportViolation(totals, cur, p, "kicked without reaching the ball");
+        if (player[RAN] != (before == NULL ? 0 : before[RAN]) + run ||
+            player[REACHED] != (before == NULL ? 0 : before[REACHED]) + player[HAS_REACHED] ||
+            player[KICKED] != (before == NULL ? 0 : before[KICKED]) + player[HAS_KICKED])
+        {
+            reportViolation(totals, cur, p, "counters do not add up");
+        }
+        kicks += player[HAS_KICKED];
+        reached += player[HAS_REACHED];
+
+        totals->stats[p].distance += run;
+        totals->stats[p].reached += player[HAS_REACHED];
+        totals->stats[p].kicked += player[HAS_KICKED];
+    }
+
+    // the field picks one kicker among everyone who reached the ball
+    if (kicks != (reached > 0)) reportViolation(totals, cur, NO_PLAYER, "not exactly one kicker");
+}
+
+void printTrainingStats(player_stats stats[], int numPlayers)
+{
+    int p;
+    printf("player distance reached kicked\n");
+    for (p = 0; p < numPlayers; p++)
+    {
+        printf("%d %ld %ld %ld\n", p, stats[p].distance, stats[p].reached, stats[p].kicked);
+    }
+}
@@ -0,0 +1,232 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "kernel_bench.h"
+#include "match_game.h"
+
+// Times the movement and kicking rules without MPI, e.g.
+//   ./kernel_bench -n 100000 -b 22 -m match.lab.o -t training.lab.o
+// Every kernel runs over uniform positions, positions close to the ball
+// and positions replayed from traces, with ns per call and players per
+// second over the timed repetitions.
+
+#define MAX_REPLAYS 4
+
+int warmup = 3;
+int reps = 20;
+volatile long sink;
+
+double now(void);
+int compareDoubles(const void* a, const void* b);
+void allocateSamples(bench_samples* samples, int n, int numBlocks);
+
+int main(int argc, char **argv)
+{
+    int opt, r;
+    int n = 1 << 16;
+    int block = 22;
+    int numReplays = 0;
+    bench_samples replays[MAX_REPLAYS];
+
+    while ((opt = getopt(argc, argv, "n:b:r:w:m:t:" CONFIG_OPTIONS)) != -1)
+    {
+        if (opt == 'n') n = atoi(optarg);
+        else if (opt == 'b') block = atoi(optarg);
+        else if (opt == 'r') reps = atoi(optarg);
+        else if (opt == 'w') warmup = atoi(optarg);
+        else if ((opt == 'm' || opt == 't') && numReplays < MAX_REPLAYS)
+        {
+            if (!loadTraceSamples(&replays[numReplays], optarg))
+            {
+                fprintf(stderr, "%s: no positions found\n", optarg);
+                return 1;
+            }
+            numReplays++;
+        }
+        else if (!parseConfigOption(opt, optarg)) n = 0;
+    }
+    const char* error = finishConfig();
+    if (n <= 0 || block <= 0 || reps <= 0 || warmup < 0 || error != NULL)
+    {
+        if (error != NULL) fprintf(stderr, "%s: %s\n", argv[0], error);
+        fprintf(stderr, "Usage: %s [-n players] [-b players per ball] [-r repetitions] [-w warm-up passes] "
+            "[-m match trace] [-t training trace] " CONFIG_USAGE "\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-22s %-16s %9s %9s %9s %9s %12s\n", "kernel", "positions", "min ns", "median ns", "mean ns", "sd ns", "players/s");
+    benchMatchKernels(n, block, replays, numReplays);
+    benchTrainingKernels(n, block, replays, numReplays);
+
+    for (r = 0; r < numReplays; r++) freeSamples(&replays[r]);
+    return 0;
+}
+
+double now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+int compareDoubles(const void* a, const void* b)
+{
+    double x = *(const double*) a, y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+void benchRun(const char* kernel, bench_samples* samples, bench_pass pass, void* data)
+{
+    int r;
+    long checksum = 0;
+    double sum = 0, squares = 0;
+    double* times = malloc(reps * sizeof(double));
+
+    for (r = 0; r < warmup; r++) checksum += pass(samples, data);
+    for (r = 0; r < reps; r++)
+    {
+        double start = now();
+        checksum += pass(samples, data);
+        times[r] = (now() - start) * 1e9 / samples->n;
+        sum += times[r];
+        squares += times[r] * times[r];
+    }
+    sink += checksum;
+
+    qsort(times, reps, sizeof(double), compareDoubles);
+    double mean = sum / reps;
+    double median = (reps % 2) ? times[reps / 2] : (times[reps / 2 - 1] + times[reps / 2]) / 2;
+    double sd = sqrt(fmax(squares / reps - mean * mean, 0));
+    printf("%-22s %-16s %9.2f %9.2f %9.2f %9.2f %12.3e\n", kernel, samples->name, times[0], median, mean, sd,
+        median > 0 ? 1e9 / median : 0.0);
+    free(times);
+}
+
+void allocateSamples(bench_samples* samples, int n, int numBlocks)
+{
+    samples->n = n;
+    samples->x = malloc(n * sizeof(int));
+    samples->y = malloc(n * sizeof(int));
+    samples->ballX = malloc(n * sizeof(int));
+    samples->ballY = malloc(n * sizeof(int));
+    samples->numBlocks = numBlocks;
+    samples->blockStart = malloc((numBlocks + 1) * sizeof(int));
+}
+
+void freeSamples(bench_samples* samples)
+{
+    free(samples->x);
+    free(samples->y);
+    free(samples->ballX);
+    free(samples->ballY);
+    free(samples->blockStart);
+}
+
+// players anywhere on the field, like the scattered positions at kick-off
+void makeUniformSamples(bench_samples* samples, int n, int block, int length, int width)
+{
+    int b, p;
+    rand_stream rng;
+    seedRandom(&rng, 1);
+    allocateSamples(samples, n, (n + block - 1) / block);
+    samples->name = "uniform";
+    for (b = 0; b < samples->numBlocks; b++)
+    {
+        int ballX = nextRandom(&rng) % length;
+        int ballY = nextRandom(&rng) % width;
+        samples->blockStart[b] = b * block;
+        for (p = b * block; p < n && p < (b + 1) * block; p++)
+        {
+            samples->x[p] = nextRandom(&rng) % length;
+            samples->y[p] = nextRandom(&rng) % width;
+            samples->ballX[p] = ballX;
+            samples->ballY[p] = ballY;
+        }
+    }
+    samples->blockStart[samples->numBlocks] = n;
+}
+
+// players within 12 of the ball on each axis, like a pack chasing it
+void makeNearBallSamples(bench_samples* samples, int n, int block, int length, int width)
+{
+    int p;
+    makeUniformSamples(samples, n, block, length, width);
+    samples->name = "near ball";
+    rand_stream rng;
+    seedRandom(&rng, 2);
+    for (p = 0; p < n; p++)
+    {
+        int x = samples->ballX[p] + nextRandom(&rng) % 25 - 12;
+        int y = samples->ballY[p] + nextRandom(&rng) % 25 - 12;
+        samples->x[p] = x < 0 ? 0 : (x >= length ? length - 1 : x);
+        samples->y[p] = y < 0 ? 0 : (y >= width ? width - 1 : y);
+    }
+}
+
+// Reads the initial position of every player line in a match or training
+// trace. A line with one number starts a round, two numbers are the ball.
+int loadTraceSamples(bench_samples* samples, const char* path)
+{
+    char line[512];
+    int capacity = 1 << 16, blockCapacity = 1 << 12;
+    int ballX = 0, ballY = 0;
+    FILE* file = fopen(path, "r");
+    if (file == NULL) return 0;
+
+    allocateSamples(samples, capacity, blockCapacity);
+    samples->name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    samples->n = 0;
+    samples->numBlocks = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        int values[3], count = 0;
+        char* cursor = line;
+        char* end;
+        long value = strtol(cursor, &end, 10);
+        while (end != cursor)
+        {
+            if (count < 3) values[count] = (int) value;
+            count++;
+            cursor = end;
+            value = strtol(cursor, &end, 10);
+        }
+
+        if (count == 1)
+        {
+            if (samples->numBlocks + 1 >= blockCapacity)
+            {
+                blockCapacity *= 2;
+                samples->blockStart = realloc(samples->blockStart, (blockCapacity + 1) * sizeof(int));
+            }
+            samples->blockStart[samples->numBlocks++] = samples->n;
+        }
+        else if (count == 2)
+        {
+            ballX = values[0];
+            ballY = values[1];
+        }
+        else if (count >= 8 && samples->numBlocks > 0)
+        {
+            if (samples->n == capacity)
+            {
+                capacity *= 2;
+                samples->x = realloc(samples->x, capacity * sizeof(int));
+                samples->y = realloc(samples->y, capacity * sizeof(int));
+                samples->ballX = realloc(samples->ballX, capacity * sizeof(int));
+                samples->ballY = realloc(samples->ballY, capacity * sizeof(int));
+            }
+            samples->x[samples->n] = values[1];
+            samples->y[samples->n] = values[2];
+            samples->ballX[samples->n] = ballX;
+            samples->ballY[samples->n] = ballY;
+            samples->n++;
+        }
+    }
+    fclose(file);
+    samples->blockStart[samples->numBlocks] = samples->n;
+    return samples->n > 0;
+}
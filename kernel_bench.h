@@ -0,0 +1,35 @@
+#ifndef KERNEL_BENCH_H
+#define KERNEL_BENCH_H
+
+// Player positions for the kernels to chew on. Players come in blocks
+// that share a ball, like the players of one round.
+typedef struct
+{
+    const char* name;       // where the positions came from
+    int n;
+    int* x;
+    int* y;
+    int* ballX;             // ball of the player's block
+    int* ballY;
+    int numBlocks;
+    int* blockStart;        // block b is blockStart[b]..blockStart[b + 1] - 1
+} bench_samples;
+
+// One timed pass over every sample. Returns a checksum so the compiler
+// cannot drop the work.
+typedef long (*bench_pass)(bench_samples* samples, void* data);
+
+// distributions
+void makeUniformSamples(bench_samples* samples, int n, int block, int length, int width);
+void makeNearBallSamples(bench_samples* samples, int n, int block, int length, int width);
+int loadTraceSamples(bench_samples* samples, const char* path);
+void freeSamples(bench_samples* samples);
+
+// runs the warm-up passes, then times every repetition and prints a line
+void benchRun(const char* kernel, bench_samples* samples, bench_pass pass, void* data);
+
+// suites, one per game so their types do not meet
+void benchMatchKernels(int n, int block, bench_samples replays[], int numReplays);
+void benchTrainingKernels(int n, int block, bench_samples replays[], int numReplays);
+
+#endif
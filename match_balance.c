@@ -0,0 +1,101 @@
+#include <stdlib.h>
+
+#include "match_balance.h"
+
+void initTiles(field_tiles* tiles, int rows, int cols)
+{
+    int row, col;
+    tiles->rows = rows;
+    tiles->cols = cols;
+    tiles->count = rows * cols;
+    tiles->owner = malloc(tiles->count * sizeof(int));
+    tiles->load = calloc(tiles->count, sizeof(long));
+
+    // a tile starts out with the cell its corner lies in
+    for (row = 0; row < rows; row++)
+    {
+        for (col = 0; col < cols; col++)
+        {
+            pos corner = {cellStart(col, config.length, cols), cellStart(row, config.width, rows)};
+            tiles->owner[row * cols + col] = getFieldProcess(corner);
+        }
+    }
+}
+
+void freeTiles(field_tiles* tiles)
+{
+    free(tiles->owner);
+    free(tiles->load);
+}
+
+int getTile(field_tiles* tiles, pos position)
+{
+    int col = cellIndex(position.x, config.length, tiles->cols);
+    int row = cellIndex(position.y, config.width, tiles->rows);
+    return row * tiles->cols + col;
+}
+
+int getOwner(field_tiles* tiles, pos position)
+{
+    return tiles->owner[getTile(tiles, position)];
+}
+
+// gap between the ranges [firstA, endA) and [firstB, endB), 0 if they overlap
+static int gapBetween(int firstA, int endA, int firstB, int endB)
+{
+    if (firstB >= endA) return firstB - (endA - 1);
+    if (firstA >= endB) return firstA - (endB - 1);
+    return 0;
+}
+
+int isTileInReach(field_tiles* tiles, int a, int b)
+{
+    int rowA = a / tiles->cols, colA = a % tiles->cols;
+    int rowB = b / tiles->cols, colB = b % tiles->cols;
+    int gapX = gapBetween(cellStart(colA, config.length, tiles->cols), cellStart(colA + 1, config.length, tiles->cols),
+        cellStart(colB, config.length, tiles->cols), cellStart(colB + 1, config.length, tiles->cols));
+    int gapY = gapBetween(cellStart(rowA, config.width, tiles->rows), cellStart(rowA + 1, config.width, tiles->rows),
+        cellStart(rowB, config.width, tiles->rows), cellStart(rowB + 1, config.width, tiles->rows));
+    return gapX <= MAX_STEP && gapY <= MAX_STEP;
+}
+
+// A tile goes to the strip its midpoint on the walk falls into. A tile
+// hotter than a whole strip gets a rank of its own and leaves the ranks
+// it skips idle, as no cut can do better than that tile alone.
+void balanceTiles(field_tiles* tiles, long load[], int owner[])
+{
+    int row, col, unit;
+    long total = 0, before = 0;
+
+    for (unit = 0; unit < tiles->count; unit++) total += load[unit];
+    unit = (total == 0);            // nothing measured, split by area
+
+    for (row = 0; row < tiles->rows; row++)
+    {
+        for (col = 0; col < tiles->cols; col++)
+        {
+            // odd rows are walked backwards so consecutive tiles touch
+            int tile = row * tiles->cols + (row % 2 == 0 ? col : tiles->cols - 1 - col);
+            long weight = unit ? 1 : load[tile];
+            long sum = unit ? tiles->count : total;
+            int rank = (int) ((2 * before + weight) * config.numFields / (2 * sum));
+            owner[tile] = rank < config.numFields ? rank : config.numFields - 1;
+            before += weight;
+        }
+    }
+}
+
+long heaviestOwner(field_tiles* tiles, long load[], int owner[])
+{
+    int tile, rank;
+    long heaviest = 0;
+    long* perRank = calloc(config.numFields, sizeof(long));
+
+    for (tile = 0; tile < tiles->count; tile++) perRank[owner[tile]] += load[tile];
+    for (rank = 0; rank < config.numFields; rank++)
+    {
+        if (perRank[rank] > heaviest) heaviest = perRank[rank];
+    }
+    free(perRank);
+    return heaviest;
+}
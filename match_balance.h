@@ -0,0 +1,36 @@
+#ifndef MATCH_BALANCE_H
+#define MATCH_BALANCE_H
+
+#include "match_game.h"
+
+// Which field rank serves which part of the field in the cart protocol.
+// The field is cut into tiles, a grid at least as fine as the cells, and
+// every tile has an owner. The game rules still work on cells; owners only
+// decide which rank serves the players standing on a tile. At first each
+// rank owns the tiles of its own cell, so with tiles equal to the cells
+// this is the one cell per rank layout.
+typedef struct
+{
+    int rows;           // tiles across the width
+    int cols;           // tiles along the length
+    int count;
+    int* owner;         // field rank of every tile
+    long* load;         // work seen on every tile since the last rebalance
+} field_tiles;
+
+void initTiles(field_tiles* tiles, int rows, int cols);
+void freeTiles(field_tiles* tiles);
+int getTile(field_tiles* tiles, pos position);
+int getOwner(field_tiles* tiles, pos position);
+
+// 1 if a player on tile a can end the round on tile b
+int isTileInReach(field_tiles* tiles, int a, int b);
+
+// Cuts the tiles into numFields strips of about equal load along a
+// serpentine walk over the tile rows, so ranks keep compact areas
+void balanceTiles(field_tiles* tiles, long load[], int owner[]);
+
+// load of the busiest rank when the tiles are owned by owner[]
+long heaviestOwner(field_tiles* tiles, long load[], int owner[]);
+
+#endif
@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "match_checkpoint.h"
+
+void initCheckpoint(match_checkpoint* header, int seed, int half, int round, int tick)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic));
+    header->config = config;
+    header->seed = seed;
+    header->half = half;
+    header->round = round;
+    header->tick = tick;
+}
+
+// Writes next to the old checkpoint and renames over it, so a run killed
+// while saving still leaves the previous checkpoint intact
+const char* saveCheckpoint(char* path, match_checkpoint* header, player_checkpoint players[])
+{
+    char temp[4096];
+    FILE* file;
+    int ok;
+
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    file = fopen(temp, "wb");
+    if (file == NULL) return "cannot create the checkpoint";
+    ok = fwrite(header, sizeof(*header), 1, file) == 1;
+    ok = ok && fwrite(players, sizeof(player_checkpoint), config.numPlayers, file) == (size_t) config.numPlayers;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(temp, path) != 0)
+    {
+        remove(temp);
+        return "cannot write the checkpoint";
+    }
+    return NULL;
+}
+
+// The players are allocated here and freed by the caller
+const char* loadCheckpoint(char* path, match_checkpoint* header, player_checkpoint** players)
+{
+    FILE* file = fopen(path, "rb");
+    *players = NULL;
+    if (file == NULL) return "cannot open the checkpoint";
+
+    if (fread(header, sizeof(*header), 1, file) != 1 || memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0)
+    {
+        fclose(file);
+        return "not a match checkpoint";
+    }
+    if (memcmp(&header->config, &config, sizeof(config)) != 0)
+    {
+        fclose(file);
+        return "the checkpoint was taken with a different field, grid, team size, rounds or rng";
+    }
+
+    *players = malloc(config.numPlayers * sizeof(player_checkpoint));
+    if (fread(*players, sizeof(player_checkpoint), config.numPlayers, file) != (size_t) config.numPlayers)
+    {
+        fclose(file);
+        free(*players);
+        *players = NULL;
+        return "the checkpoint is truncated";
+    }
+    fclose(file);
+    return NULL;
+}
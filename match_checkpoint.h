@@ -0,0 +1,40 @@
+#ifndef MATCH_CHECKPOINT_H
+#define MATCH_CHECKPOINT_H
+
+#include "match_game.h"
+
+#define CHECKPOINT_MAGIC "MATCHCK1"
+
+// A checkpoint is this header followed by one player_checkpoint per
+// player in rank order. It is taken between rounds, so a match resumed
+// from it prints exactly the rest of the trace. match_mpi and match_smp
+// write the same format and can resume each other's checkpoints.
+typedef struct
+{
+    char magic[8];
+    match_config config;        // must match the resuming run
+    int seed;
+    int half;                   // next round to play, round 0 means
+    int round;                  // the half has not kicked off yet
+    int tick;                   // random round the last round used
+    pos ball;
+    int goalA, goalB;
+    int Ascore, Bscore;
+
+    // only tracked by the shared-memory engine
+    int kicksA, kicksB;
+    int possession;
+    int possessionA, possessionB;
+} match_checkpoint;
+
+typedef struct
+{
+    football_player player;
+    rand_stream rng;
+} player_checkpoint;
+
+void initCheckpoint(match_checkpoint* header, int seed, int half, int round, int tick);
+const char* saveCheckpoint(char* path, match_checkpoint* header, player_checkpoint players[]);
+const char* loadCheckpoint(char* path, match_checkpoint* header, player_checkpoint** players);
+
+#endif
@@ -0,0 +1,354 @@
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "match_checkpoint.h"
+#include "match_engine.h"
+#include "match_kernels.h"
+
+// below this many players a parallel region costs more than the loop
+#define PARALLEL_MIN_PLAYERS 256
+
+void engineInit(match_engine* engine, int seed)
+{
+    engineInitPlayers(engine, seed, config.numFields, config.numPlayers);
+}
+
+void engineInitPlayers(match_engine* engine, int seed, int first, int n)
+{
+    int p;
+
+    engine->n = n;
+    engine->first = first;
+    engine->initialX = malloc(n * sizeof(int));
+    engine->initialY = malloc(n * sizeof(int));
+    engine->x = malloc(n * sizeof(int));
+    engine->y = malloc(n * sizeof(int));
+    engine->reached = malloc(n * sizeof(int));
+    engine->kicked = malloc(n * sizeof(int));
+    engine->challenge = malloc(n * sizeof(int));
+    engine->speed = malloc(n * sizeof(int));
+    engine->dribbling = malloc(n * sizeof(int));
+    engine->kick = malloc(n * sizeof(int));
+    engine->rng = malloc(n * sizeof(rand_stream));
+    engine->targetX = malloc(n * sizeof(int));
+    engine->targetY = malloc(n * sizeof(int));
+    engine->inField = malloc(n * sizeof(int));
+    engine->inRange = malloc(n * sizeof(int));
+
+    // same draws as initPlayers on each player rank
+    for (p = 0; p < n; p++)
+    {
+        football_player player;
+        seedEntity(&engine->rng[p], seed, engine->first + p);
+        initPlayers(engine->first + p, &engine->rng[p], &player);
+        engine->initialX[p] = player.initial.x;
+        engine->initialY[p] = player.initial.y;
+        engine->x[p] = player.final.x;
+        engine->y[p] = player.final.y;
+        engine->reached[p] = player.reached;
+        engine->kicked[p] = player.kicked;
+        engine->challenge[p] = player.challenge;
+        engine->speed[p] = player.speed;
+        engine->dribbling[p] = player.dribbling;
+        engine->kick[p] = player.kick;
+    }
+
+    initField(&engine->goalA, &engine->goalB, &engine->ball);
+    engine->Ascore = 0;
+    engine->Bscore = 0;
+    engine->kicksA = 0;
+    engine->kicksB = 0;
+    engine->possession = NO_POSSESSION;
+    engine->possessionA = 0;
+    engine->possessionB = 0;
+    engine->tick = 0;
+}
+
+void engineFree(match_engine* engine)
+{
+    free(engine->initialX);
+    free(engine->initialY);
+    free(engine->x);
+    free(engine->y);
+    free(engine->reached);
+    free(engine->kicked);
+    free(engine->challenge);
+    free(engine->speed);
+    free(engine->dribbling);
+    free(engine->kick);
+    free(engine->rng);
+    free(engine->targetX);
+    free(engine->targetY);
+    free(engine->inField);
+    free(engine->inRange);
+}
+
+void engineStartHalf(match_engine* engine)
+{
+    int p;
+    swapGoals(&engine->goalA, &engine->goalB);
+    engine->tick++;
+    for (p = 0; p < engine->n; p++)
+    {
+        pos target;
+        setRandomRound(&engine->rng[p], engine->tick);
+        getRandomPos(engine->first + p, &engine->rng[p], &target);
+        engine->x[p] = engine->initialX[p] = target.x;
+        engine->y[p] = engine->initialY[p] = target.y;
+    }
+}
+
+void enginePlayRound(match_engine* engine)
+{
+    int topChallenge;
+    int winner = engineMovePlayers(engine, &topChallenge);
+    pos target = engine->ball;
+
+    if (winner != NO_WINNER) engineAimBall(engine, winner, &target);
+    engineEndRound(engine, winner == NO_WINNER ? NO_WINNER : engine->first + winner, target);
+}
+
+int engineMovePlayers(match_engine* engine, int* topChallenge)
+{
+    int p;
+    int n = engine->n;
+    pos ball = engine->ball;
+    int tick = ++engine->tick;
+
+    // every player moves and, if it reached the ball, rolls its challenge.
+    // Each thread runs the batch kernels over its own block of players.
+    #pragma omp parallel private(p) if (n >= PARALLEL_MIN_PLAYERS)
+    {
+        int first = 0, count = n;
+#ifdef _OPENMP
+        int threads = omp_get_num_threads();
+        int thread = omp_get_thread_num();
+        first = (int) ((long) n * thread / threads);
+        count = (int) ((long) n * (thread + 1) / threads) - first;
+#endif
+        int last = first + count;
+
+        for (p = first; p < last; p++)
+        {
+            engine->initialX[p] = engine->x[p];
+            engine->initialY[p] = engine->y[p];
+            engine->kicked[p] = 0;
+            engine->reached[p] = 0;
+            engine->challenge[p] = -1;
+        }
+        inBallFieldBatch(count, engine->initialX + first, engine->initialY + first, ball, engine->inField + first);
+        ballWithinRangeBatch(count, engine->initialX + first, engine->initialY + first, engine->speed + first, ball,
+            engine->inRange + first);
+
+        // run after ball, or move to default position
+        for (p = first; p < last; p++)
+        {
+            pos target = ball;
+            setRandomRound(&engine->rng[p], tick);
+            if (!engine->inField[p] && !engine->inRange[p]) getRandomPos(engine->first + p, &engine->rng[p], &target);
+            engine->targetX[p] = target.x;
+            engine->targetY[p] = target.y;
+        }
+        tryToReachBatch(count, engine->initialX + first, engine->initialY + first, engine->targetX + first,
+            engine->targetY + first, engine->speed + first, engine->x + first, engine->y + first);
+
+        for (p = first; p < last; p++)
+        {
+            if (engine->x[p] == ball.x && engine->y[p] == ball.y)
+            {
+                engine->challenge[p] = rollChallenge(&engine->rng[p], engine->dribbling[p]);
+                engine->reached[p] = 1;
+            }
+        }
+    }
+
+    // the first player with the strictly highest challenge wins
+    int winner = NO_WINNER;
+    *topChallenge = 0;
+    for (p = 0; p < n; p++)
+    {
+        if (engine->challenge[p] > *topChallenge)
+        {
+            *topChallenge = engine->challenge[p];
+            winner = p;
+        }
+    }
+    return winner;
+}
+
+void engineAimBall(match_engine* engine, int p, pos* target)
+{
+    football_player player;
+    int rank = engine->first + p;
+    player.final.x = engine->x[p];
+    player.final.y = engine->y[p];
+    player.kick = engine->kick[p];
+    aimBall(target, player, isTeamA(rank) ? engine->goalA : engine->goalB, &engine->rng[p]);
+}
+
+void engineEndRound(match_engine* engine, int kicker, pos target)
+{
+    if (kicker != NO_WINNER)
+    {
+        int p = kicker - engine->first;
+        kickBall(target, &engine->ball);
+        if (p >= 0 && p < engine->n) engine->kicked[p] = 1;
+        if (isTeamA(kicker)) engine->kicksA++;
+        else engine->kicksB++;
+        engine->possession = isTeamA(kicker) ? TEAM_A : TEAM_B;
+    }
+
+    if (isGoal(engine->ball))
+    {
+        incrementScore(engine->ball, engine->goalA, engine->goalB, &engine->Ascore, &engine->Bscore);
+        resetBall(&engine->ball);
+        engine->possession = NO_POSSESSION;
+    }
+
+    if (engine->possession == TEAM_A) engine->possessionA++;
+    else if (engine->possession == TEAM_B) engine->possessionB++;
+}
+
+void enginePrintRound(match_engine* engine, int round)
+{
+    int p;
+    printf("%d\n", round);
+    printf("%d %d\n", engine->ball.x, engine->ball.y);
+    for (p = 0; p < engine->n; p++)
+    {
+        int rank = engine->first + p;
+        printf("%d %d %d %d %d %d %d %d \n", rank - config.numFields - (isTeamA(rank) ? 0 : config.teamSize),
+            engine->initialX[p], engine->initialY[p], engine->x[p], engine->y[p],
+            engine->reached[p], engine->kicked[p], engine->challenge[p]);
+    }
+}
+
+void engineWriteRound(match_engine* engine, binary_trace* trace, int round)
+{
+    int p;
+    int* values = malloc(engine->n * matchLayout.fields * sizeof(int));
+    for (p = 0; p < engine->n; p++)
+    {
+        int rank = engine->first + p;
+        int* value = &values[p * matchLayout.fields];
+        value[0] = rank - config.numFields - (isTeamA(rank) ? 0 : config.teamSize);
+        value[1] = engine->initialX[p];
+        value[2] = engine->initialY[p];
+        value[3] = engine->x[p];
+        value[4] = engine->y[p];
+        value[5] = engine->reached[p];
+        value[6] = engine->kicked[p];
+        value[7] = engine->challenge[p];
+    }
+    writeTraceRound(trace, round, engine->ball.x, engine->ball.y, values);
+    free(values);
+}
+
+void engineTally(match_engine* engine, match_tally* tally, int round)
+{
+    int p;
+    for (p = 0; p < engine->n; p++)
+    {
+        tallyPlayer(tally, p, isTeamA(engine->first + p) ? 0 : 1, round, engine->initialX[p], engine->initialY[p],
+            engine->x[p], engine->y[p], engine->reached[p], engine->kicked[p],
+            engine->kicked[p] && engine->possession == NO_POSSESSION);
+    }
+}
+
+void engineGetPlayer(match_engine* engine, int p, football_player* player)
+{
+    player->id = engine->first + p;
+    player->initial.x = engine->initialX[p];
+    player->initial.y = engine->initialY[p];
+    player->final.x = engine->x[p];
+    player->final.y = engine->y[p];
+    player->reached = engine->reached[p];
+    player->kicked = engine->kicked[p];
+    player->challenge = engine->challenge[p];
+    player->speed = engine->speed[p];
+    player->dribbling = engine->dribbling[p];
+    player->kick = engine->kick[p];
+}
+
+void engineCheckpoint(match_engine* engine, match_checkpoint* header, player_checkpoint players[], int seed, int half, int round)
+{
+    int p;
+    initCheckpoint(header, seed, half, round, engine->tick);
+    header->ball = engine->ball;
+    header->goalA = engine->goalA;
+    header->goalB = engine->goalB;
+    header->Ascore = engine->Ascore;
+    header->Bscore = engine->Bscore;
+    header->kicksA = engine->kicksA;
+    header->kicksB = engine->kicksB;
+    header->possession = engine->possession;
+    header->possessionA = engine->possessionA;
+    header->possessionB = engine->possessionB;
+
+    for (p = 0; p < engine->n; p++)
+    {
+        engineGetPlayer(engine, p, &players[p].player);
+        players[p].rng = engine->rng[p];
+    }
+}
+
+void engineRestore(match_engine* engine, match_checkpoint* header, player_checkpoint players[])
+{
+    int p;
+    engine->tick = header->tick;
+    engine->ball = header->ball;
+    engine->goalA = header->goalA;
+    engine->goalB = header->goalB;
+    engine->Ascore = header->Ascore;
+    engine->Bscore = header->Bscore;
+    engine->kicksA = header->kicksA;
+    engine->kicksB = header->kicksB;
+    engine->possession = header->possession;
+    engine->possessionA = header->possessionA;
+    engine->possessionB = header->possessionB;
+
+    for (p = 0; p < engine->n; p++)
+    {
+        football_player* player = &players[p].player;
+        engine->initialX[p] = player->initial.x;
+        engine->initialY[p] = player->initial.y;
+        engine->x[p] = player->final.x;
+        engine->y[p] = player->final.y;
+        engine->reached[p] = player->reached;
+        engine->kicked[p] = player->kicked;
+        engine->challenge[p] = player->challenge;
+        engine->speed[p] = player->speed;
+        engine->dribbling[p] = player->dribbling;
+        engine->kick[p] = player->kick;
+        engine->rng[p] = players[p].rng;
+    }
+}
+
+const char* engineSave(match_engine* engine, char* path, int seed, int half, int round)
+{
+    const char* error;
+    match_checkpoint header;
+    player_checkpoint* players = malloc(engine->n * sizeof(player_checkpoint));
+
+    engineCheckpoint(engine, &header, players, seed, half, round);
+    error = saveCheckpoint(path, &header, players);
+    free(players);
+    return error;
+}
+
+const char* engineLoad(match_engine* engine, char* path, int* half, int* round)
+{
+    match_checkpoint header;
+    player_checkpoint* players;
+    const char* error = loadCheckpoint(path, &header, &players);
+    if (error != NULL) return error;
+
+    *half = header.half;
+    *round = header.round;
+    engineRestore(engine, &header, players);
+    free(players);
+    return NULL;
+}
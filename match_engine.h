@@ -0,0 +1,81 @@
+#ifndef MATCH_ENGINE_H
+#define MATCH_ENGINE_H
+
+#include "match_checkpoint.h"
+#include "match_game.h"
+#include "match_stats.h"
+
+// Shared-memory match engine. Every player lives in the same process and
+// its state is kept as struct-of-arrays so a round is a handful of loops
+// over contiguous buffers instead of messages between ranks.
+typedef struct
+{
+    int n;              // number of players
+    int first;          // world rank the MPI build gives to the engine's player 0
+
+    // per player state, indexed 0..n-1
+    int* initialX;
+    int* initialY;
+    int* x;             // final position of the current round
+    int* y;
+    int* reached;
+    int* kicked;
+    int* challenge;
+
+    // per player attributes
+    int* speed;
+    int* dribbling;
+    int* kick;
+
+    // one stream per player so results match the one-rank-per-player build
+    rand_stream* rng;
+    int tick;           // random round: 0 at set-up, then each kick-off and round
+
+    // scratch space for the batch kernels
+    int* targetX;
+    int* targetY;
+    int* inField;       // standing in the ball's cell
+    int* inRange;       // close enough to step onto the ball
+
+    pos ball;
+    int goalA, goalB;
+    int Ascore, Bscore;
+
+    // match statistics
+    int kicksA, kicksB;
+    int possession;             // team of the last kicker, NO_POSSESSION after a goal
+    int possessionA, possessionB;   // rounds each team ended in possession
+} match_engine;
+
+#define NO_POSSESSION 0
+#define TEAM_A 1
+#define TEAM_B 2
+
+// seed s plays the same match as match_mpi -s s, see seedEntity.
+// finishConfig must have been called first.
+void engineInit(match_engine* engine, int seed);
+void engineFree(match_engine* engine);
+void engineStartHalf(match_engine* engine);
+void enginePlayRound(match_engine* engine);
+void enginePrintRound(match_engine* engine, int round);
+void engineWriteRound(match_engine* engine, binary_trace* trace, int round);
+void engineTally(match_engine* engine, match_tally* tally, int round);
+
+// An engine can also hold only the n players from world rank first on,
+// for matches split over several processes. enginePlayRound is then done
+// in steps: engineMovePlayers returns the engine's own winner, or
+// NO_WINNER, and its challenge; whoever holds the overall winner aims with
+// engineAimBall and every engine ends the round with that kicker and target.
+void engineInitPlayers(match_engine* engine, int seed, int first, int n);
+int engineMovePlayers(match_engine* engine, int* topChallenge);
+void engineAimBall(match_engine* engine, int p, pos* target);
+void engineEndRound(match_engine* engine, int kicker, pos target);
+void engineGetPlayer(match_engine* engine, int p, football_player* player);
+
+// half and round are the next round to play, see match_checkpoint.h
+const char* engineSave(match_engine* engine, char* path, int seed, int half, int round);
+const char* engineLoad(match_engine* engine, char* path, int* half, int* round);
+void engineCheckpoint(match_engine* engine, match_checkpoint* header, player_checkpoint players[], int seed, int half, int round);
+void engineRestore(match_engine* engine, match_checkpoint* header, player_checkpoint players[]);
+
+#endif
@@ -0,0 +1,231 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "match_sim.h"
+
+// Plays many independent matches in one job and writes one line of
+// aggregate results per match instead of a trace, e.g.
+//   mpirun -np 8 ./match_ensemble -m 10000 -s 0 -o results.csv
+// Every rank plays whole matches with the shared-memory engine, one per
+// OpenMP thread. Running the same command again resumes the ensemble:
+// seeds already present in the output file are skipped. The file starts
+// with the config its matches were played with, and a run with another
+// config refuses to add to it.
+
+#define RESULT_FIELDS 7
+#define CONFIG_LINE 256
+
+typedef struct
+{
+    int seed;               // -1 for an empty slot
+    int Ascore, Bscore;
+    int kicksA, kicksB;
+    int possessionA, possessionB;
+} match_result;
+
+void parseOptions(int argc, char **argv, int worldRank, int* matches, int* firstSeed, char** output);
+void describeConfig(char* line);
+int findPendingSeeds(char* output, char* configLine, int matches, int firstSeed, int* pending);
+void playMatch(int seed, match_result* result);
+FILE* openResults(char* output, char* configLine);
+void writeResult(FILE* file, match_result* result);
+
+int main(int argc, char **argv)
+{
+    int worldSize, worldRank;
+    MPI_Init(NULL, NULL);
+    MPI_Comm_size(MPI_COMM_WORLD, &worldSize);
+    MPI_Comm_rank(MPI_COMM_WORLD, &worldRank);
+
+    int matches, firstSeed, numPending, start, i;
+    char* output;
+    char configLine[CONFIG_LINE];
+    parseOptions(argc, argv, worldRank, &matches, &firstSeed, &output);
+    describeConfig(configLine);
+
+    // rank 0 works out what is left to do and hands the list to everyone
+    int* pending = malloc(matches * sizeof(int));
+    if (worldRank == 0) numPending = findPendingSeeds(output, configLine, matches, firstSeed, pending);
+    MPI_Bcast(&numPending, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(pending, numPending, MPI_INT, 0, MPI_COMM_WORLD);
+
+    int perRank = 1;
+#ifdef _OPENMP
+    perRank = omp_get_max_threads();
+#endif
+    int batch = perRank * worldSize;
+    match_result* results = malloc(perRank * sizeof(match_result));
+    match_result* collected = NULL;
+    FILE* file = NULL;
+    if (worldRank == 0)
+    {
+        collected = malloc(batch * sizeof(match_result));
+        file = openResults(output, configLine);
+    }
+
+    double startTime = MPI_Wtime();
+    for (start = 0; start < numPending; start += batch)
+    {
+        #pragma omp parallel for schedule(dynamic)
+        for (i = 0; i < perRank; i++)
+        {
+            int index = start + worldRank * perRank + i;
+            if (index < numPending) playMatch(pending[index], &results[i]);
+            else results[i].seed = -1;
+        }
+
+        // results are written after every batch so an interrupted run loses at most one
+        MPI_Gather(results, perRank * RESULT_FIELDS, MPI_INT, collected, perRank * RESULT_FIELDS, MPI_INT, 0, MPI_COMM_WORLD);
+        if (worldRank == 0)
+        {
+            for (i = 0; i < batch; i++)
+            {
+                if (collected[i].seed >= 0) writeResult(file, &collected[i]);
+            }
+            fflush(file);
+        }
+    }
+    double elapsed = MPI_Wtime() - startTime;
+
+    if (worldRank == 0)
+    {
+        fclose(file);
+        fprintf(stderr, "%d of %d matches played in %.3f s: %.1f matches/s (%d ranks x %d threads)\n",
+            numPending, matches, elapsed, elapsed > 0 ? numPending / elapsed : 0.0, worldSize, perRank);
+    }
+
+    free(pending);
+    free(results);
+    free(collected);
+    MPI_Finalize();
+}
+
+void parseOptions(int argc, char **argv, int worldRank, int* matches, int* firstSeed, char** output)
+{
+    int opt;
+    *matches = 0;
+    *firstSeed = 0;
+    *output = "ensemble.csv";
+    while ((opt = getopt(argc, argv, "m:s:o:" CONFIG_OPTIONS)) != -1)
+    {
+        if (opt == 'm') *matches = atoi(optarg);
+        else if (opt == 's') *firstSeed = atoi(optarg);
+        else if (opt == 'o') *output = optarg;
+        else if (!parseConfigOption(opt, optarg)) *matches = 0;
+    }
+    if (*matches <= 0 || *firstSeed < 0)
+    {
+        if (worldRank == 0) fprintf(stderr, "Usage: %s -m matches [-s first seed] [-o results.csv] " CONFIG_USAGE "\n", argv[0]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    const char* error = finishConfig();
+    if (error != NULL)
+    {
+        if (worldRank == 0) fprintf(stderr, "%s: %s\n", argv[0], error);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+}
+
+// Everything the matches depend on, as the options that set it
+void describeConfig(char* line)
+{
+    snprintf(line, CONFIG_LINE, "# config -W %d -L %d -N %d -G %dx%d -T %d -g %d -R %s\n", config.width, config.length,
+        config.rounds, config.fieldRows, config.fieldCols, config.teamSize, config.goalWidth,
+        config.rng == RNG_PHILOX ? "philox" : "libc");
+}
+
+int findPendingSeeds(char* output, char* configLine, int matches, int firstSeed, int* pending)
+{
+    int i, numPending = 0;
+    char line[CONFIG_LINE];
+    char* done = calloc(matches, 1);
+    FILE* file = fopen(output, "r");
+
+    // a first line cut short is dropped with the rest by openResults
+    if (file != NULL && fgets(line, sizeof(line), file) != NULL && strchr(line, '\n') != NULL &&
+        strcmp(line, configLine) != 0)
+    {
+        configLine[strlen(configLine) - 1] = '\0';
+        fprintf(stderr, "%s: not written with %s, use another -o\n", output, configLine + 2);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (file != NULL)
+    {
+        rewind(file);
+        // a line cut short by an interrupted run does not parse and is replayed
+        while (fgets(line, sizeof(line), file) != NULL)
+        {
+            match_result result;
+            if (sscanf(line, "%d,%d,%d,%d,%d,%d,%d", &result.seed, &result.Ascore, &result.Bscore,
+                    &result.kicksA, &result.kicksB, &result.possessionA, &result.possessionB) != RESULT_FIELDS) continue;
+            if (strchr(line, '\n') == NULL) continue;
+            if (result.seed >= firstSeed && result.seed < firstSeed + matches) done[result.seed - firstSeed] = 1;
+        }
+        fclose(file);
+    }
+
+    for (i = 0; i < matches; i++)
+    {
+        if (!done[i]) pending[numPending++] = firstSeed + i;
+    }
+    free(done);
+    return numPending;
+}
+
+void playMatch(int seed, match_result* result)
+{
+    match_sim sim;
+
+    simInit(&sim, seed);
+    simRun(&sim, 2 * config.rounds);
+
+    result->seed = seed;
+    result->Ascore = sim.engine.Ascore;
+    result->Bscore = sim.engine.Bscore;
+    result->kicksA = sim.engine.kicksA;
+    result->kicksB = sim.engine.kicksB;
+    result->possessionA = sim.engine.possessionA;
+    result->possessionB = sim.engine.possessionB;
+    simFree(&sim);
+}
+
+FILE* openResults(char* output, char* configLine)
+{
+    FILE* file = fopen(output, "a+");
+    if (file == NULL)
+    {
+        perror(output);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // drop a line cut short by an interrupted run, findPendingSeeds replays it
+    fseek(file, 0, SEEK_END);
+    long end = ftell(file);
+    while (end > 0)
+    {
+        fseek(file, end - 1, SEEK_SET);
+        if (fgetc(file) == '\n') break;
+        end--;
+    }
+    if (ftruncate(fileno(file), end) != 0)
+    {
+        perror(output);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    fseek(file, 0, SEEK_END);
+
+    if (end == 0) fprintf(file, "%sseed,scoreA,scoreB,kicksA,kicksB,possessionA,possessionB\n", configLine);
+    return file;
+}
+
+void writeResult(FILE* file, match_result* result)
+{
+    fprintf(file, "%d,%d,%d,%d,%d,%d,%d\n", result->seed, result->Ascore, result->Bscore,
+        result->kicksA, result->kicksB, result->possessionA, result->possessionB);
+}
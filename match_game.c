@@ -0,0 +1,428 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "match_game.h"
+
+// derived sizes are filled in by finishConfig once the options are parsed
+match_config config = {
+    .width = DEFAULT_WIDTH,
+    .length = DEFAULT_LENGTH,
+    .rounds = DEFAULT_ROUNDS,
+    .fieldRows = DEFAULT_FIELD_ROWS,
+    .fieldCols = DEFAULT_FIELD_COLS,
+    .teamSize = DEFAULT_TEAM_SIZE,
+    .goalWidth = DEFAULT_GOAL_WIDTH,
+    .rng = RNG_LIBC,
+};
+
+// Applies one of CONFIG_OPTIONS, returns FALSE for anything else
+int parseConfigOption(int opt, char* arg)
+{
+    switch (opt)
+    {
+        case 'c': return loadConfig(arg);
+        case 'W': config.width = atoi(arg); return TRUE;
+        case 'L': config.length = atoi(arg); return TRUE;
+        case 'N': config.rounds = atoi(arg); return TRUE;
+        case 'T': config.teamSize = atoi(arg); return TRUE;
+        case 'g': config.goalWidth = atoi(arg); return TRUE;
+        case 'G': return sscanf(arg, "%dx%d", &config.fieldRows, &config.fieldCols) == 2;
+        case 'R':
+            if (strcmp(arg, "libc") == 0) config.rng = RNG_LIBC;
+            else if (strcmp(arg, "philox") == 0) config.rng = RNG_PHILOX;
+            else return FALSE;
+            return TRUE;
+    }
+    return FALSE;
+}
+
+// A config file holds one "key value" pair per line, e.g.
+//   width 960
+//   length 1280
+//   grid 6x8
+//   team 110
+//   rng philox
+// Keys are the long names of the options, # starts a comment.
+int loadConfig(char* path)
+{
+    const char* keys[] = {"width", "length", "rounds", "grid", "team", "goal", "rng"};
+    const char opts[] = {'W', 'L', 'N', 'G', 'T', 'g', 'R'};
+    char line[256], key[64], value[64];
+    int k, ok = TRUE;
+    FILE* file = fopen(path, "r");
+
+    if (file == NULL) return FALSE;
+    while (ok && fgets(line, sizeof(line), file) != NULL)
+    {
+        char* comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+        int fields = sscanf(line, "%63s %63s", key, value);
+        if (fields <= 0) continue;
+
+        ok = FALSE;
+        for (k = 0; k < 7 && fields == 2; k++)
+        {
+            if (strcmp(key, keys[k]) == 0) ok = parseConfigOption(opts[k], value);
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+// Derives the dependent sizes, returns why the configuration is unusable or NULL
+const char* finishConfig(void)
+{
+    if (config.width < 1 || config.length < 1) return "the field needs a positive width and length";
+    if (config.rounds < 1) return "a half needs at least one round";
+    if (config.teamSize < 1) return "a team needs at least one player";
+    if (config.fieldRows < 1 || config.fieldRows > config.width || config.fieldCols < 1 || config.fieldCols > config.length)
+    {
+        return "every cell of the grid needs to cover part of the field";
+    }
+    if (config.goalWidth < 1 || config.goalWidth > config.width) return "the goal has to fit on the goal line";
+
+    config.numFields = config.fieldRows * config.fieldCols;
+    config.numPlayers = 2 * config.teamSize;
+    config.numProcesses = config.numFields + config.numPlayers;
+    config.goalLow = (config.width - config.goalWidth) / 2;
+    config.goalHigh = config.goalLow + config.goalWidth - 1;
+    return NULL;
+}
+
+void initField(int* goalA, int* goalB, pos* ball)
+{
+    // Goals will be swapped after this (i.e. goalA = LEFT, goalB = RIGHT)
+    *goalA = RIGHT_GOAL;
+    *goalB = LEFT_GOAL;
+    *goalA = LEFT_GOAL;
+    *goalB = RIGHT_GOAL;
+
+    // Ball starts in the center
+    ball->x = config.length/2;
+    ball->y = config.width/2;
+}
+
+void initPlayers(int worldRank, rand_stream* rng, football_player* player)
+{
+    // player stats
+    pos target;
+    getRandomPos(worldRank, rng, &target);
+    player->id = worldRank;
+    player->initial.x = target.x;
+    player->initial.y = target.y;
+    player->final.x = player->initial.x;
+    player->final.y = player->initial.y;
+    player->reached = 0;
+    player->kicked = 0;
+    player->challenge = -1;
+    player->speed = 10;
+    player->dribbling = 1;
+    player->kick = 4;
+    
+}
+
+// Seed s gives rank r the libc stream s * numProcesses + r, so seed 0 is
+// the original srand(rank). The product wraps modulo 2^32 like srand's
+// argument, so very large seeds share streams with small ones. Counter-based
+// streams are keyed on the rank.
+void seedEntity(rand_stream* rng, int seed, int worldRank)
+{
+    if (config.rng == RNG_PHILOX) seedCounter(rng, seed, worldRank);
+    else seedRandom(rng, (unsigned int) seed * (unsigned int) config.numProcesses + (unsigned int) worldRank);
+}
+
+void getRandomPos(int worldRank, rand_stream* rng, pos* target) 
+{
+    int field = worldRank % config.numFields;
+    int col = field % config.fieldCols;
+    int row = field / config.fieldCols;
+    int x = cellStart(col, config.length, config.fieldCols);
+    int y = cellStart(row, config.width, config.fieldRows);
+    target->x = x + drawRandom(rng, DRAW_X) % (cellStart(col + 1, config.length, config.fieldCols) - x);
+    target->y = y + drawRandom(rng, DRAW_Y) % (cellStart(row + 1, config.width, config.fieldRows) - y);
+}
+
+void swapGoals(int* goalA, int* goalB)
+{
+    *goalA = (*goalA == LEFT_GOAL) ?  RIGHT_GOAL : LEFT_GOAL;
+    *goalB = (*goalB == LEFT_GOAL) ?  RIGHT_GOAL : LEFT_GOAL;
+}
+
+void incrementScore(pos ball, int goalA, int goalB, int* Ascore, int* Bscore)
+{
+    int goal;
+    if (ball.x == 0) goal = LEFT_GOAL;
+    else if (ball.x == config.length - 1) goal = RIGHT_GOAL;
+
+    if (goal == goalA) {
+        (*Ascore)++;
+    }
+    else if (goal == goalB) {
+        (*Bscore)++;
+    }
+}
+
+int isFieldProcess(int worldRank)
+{
+    return (worldRank < config.numFields);
+}
+
+int isPlayerProcess(int worldRank)
+{
+    return (worldRank >= config.numFields && worldRank < config.numProcesses);
+}
+
+int isTeamA(int worldRank)
+{
+    return (worldRank >= config.numFields && worldRank < config.numFields + config.teamSize);
+}
+
+int isTeamB(int worldRank)
+{
+    return (worldRank >= config.numFields + config.teamSize && worldRank < config.numProcesses);
+}
+
+int isFP0(int worldRank) 
+{
+    return worldRank == 0;
+}
+
+int isGoal(pos ball)
+{
+    int mouth = (ball.y >= config.goalLow && ball.y <= config.goalHigh);
+    if (ball.x == 0 && mouth) return LEFT_GOAL;
+    else if (ball.x == config.length - 1 && mouth) return RIGHT_GOAL;
+    else return NO_GOAL;
+}
+
+int isBallWithinRange(pos ball, football_player player) 
+{
+    return isWithinRange(player.initial.x, player.initial.y, ball.x, ball.y, player.speed);
+}
+
+int isWithinRange(int x, int y, int targetX, int targetY, int speed)
+{
+    int moves_left = (speed < MAX_STEP ? speed : MAX_STEP);
+    
+    int diff = x - targetX;
+    if (x < targetX) diff *= -1;
+    if (diff < moves_left) moves_left -= diff;
+    else return 0;
+
+    diff = y - targetY;
+    if (y < targetY) diff *= -1;
+    if (diff < moves_left)  moves_left -= diff;
+    else return 0;
+
+    return (moves_left >= 0);
+}
+
+int getFieldProcess(pos player) 
+{
+    if (player.x >= 0 && player.x < config.length && player.y >= 0 && player.y < config.width)
+    {
+        int col = cellIndex(player.x, config.length, config.fieldCols);
+        int row = cellIndex(player.y, config.width, config.fieldRows);
+        return row * config.fieldCols + col;
+    }
+    printf("Error: invalid player %d %d\n", player.x, player.y);
+    return -1;
+}
+
+// Cells split an axis as evenly as integer division allows: cell i starts
+// at i * extent / cells and cellIndex is the inverse of that
+int cellStart(int cell, int extent, int cells)
+{
+    return cell * extent / cells;
+}
+
+int cellIndex(int coord, int extent, int cells)
+{
+    return ((coord + 1) * cells - 1) / extent;
+}
+
+// Moves one axis coordinate towards the target by at most movesLeft
+int stepTowards(int from, int to, int movesLeft)
+{
+    int diff = from - to;
+    if (from > to) 
+    {
+        int move = (diff < movesLeft ? diff : movesLeft);
+        return from - move;
+    }
+    diff = to - from;
+    if (from < to) 
+    {
+        int move = (diff < movesLeft ? diff : movesLeft);
+        return from + move;
+    }
+    return from;
+}
+
+void tryToReach(pos target, football_player* player)
+{
+    // each axis may use the full allowance
+    int moves_left = (player->speed < MAX_STEP ? player->speed : MAX_STEP);
+    player->final.x = stepTowards(player->initial.x, target.x, moves_left);
+    player->final.y = stepTowards(player->initial.y, target.y, moves_left);
+}
+
+int rollChallenge(rand_stream* rng, int dribbling)
+{
+    return ((drawRandom(rng, DRAW_CHALLENGE) % 9) + 1) * dribbling;
+}
+
+void aimBall(pos* target, football_player player, int goal, rand_stream* rng)
+{
+    // the direction is never used, the draw keeps libc streams in step with match.lab.o
+    if (config.rng != RNG_PHILOX) (void) drawRandom(rng, DRAW_DIRECTION);
+    aimAtGoal(target, player.final, player.kick, goal);
+}
+
+// The deterministic part of aimBall, so ranks that only know where the
+// kicker stands can work out where the ball goes
+void aimAtGoal(pos* target, pos from, int kick, int goal)
+{
+    int moves_left = kick * 2;
+    target->x = from.x;
+    target->y = from.y;
+    if (goal == LEFT_GOAL) {
+        // move in x first
+        if (from.x != 0) {
+            int diff = from.x;
+            int move = (diff < moves_left ? diff : moves_left);
+            moves_left -= move;
+            target->x = from.x - move;
+        }
+        if (from.y < config.goalLow)
+        {
+            int diff = config.goalLow - from.y;
+            int move = (diff < moves_left ? diff : moves_left);
+            moves_left -= move;
+            target->y = from.y + move;
+        }
+        if (from.y > config.goalHigh)
+        {
+            int diff = from.y - config.goalHigh;
+            int move = (diff < moves_left ? diff : moves_left);
+            moves_left -= move;
+            target->y = from.y - move;
+        }
+    } 
+    else 
+    {
+        // move in x first
+        if (from.x != config.length - 1) {
+            int diff = config.length - 1 - from.x;
+            int move = (diff < moves_left ? diff : moves_left);
+            moves_left -= move;
+            target->x = from.x + move;
+        }
+        if (from.y < config.goalLow)
+        {
+            int diff = config.goalLow - from.y;
+            int move = (diff < moves_left ? diff : moves_left);
+            moves_left -= move;
+            target->y = from.y + move;
+        }
+        if (from.y > config.goalHigh)
+        {
+            int diff = from.y - config.goalHigh;
+            int move = (diff < moves_left ? diff : moves_left);
+            moves_left -= move;
+            target->y = from.y - move;
+        }
+    }
+    // printf("target %d %d\n", target->x, target->y);
+}
+
+void kickBall(pos target, pos* ball) 
+{
+    ball->x = target.x;
+    ball->y = target.y;
+}
+
+// After a goal the ball goes back to (width/2, length/2). The axes are the
+// other way round from the kick-off spot, which the reference traces rely
+// on, so that is kept and only clamped onto fields where it would be off.
+void resetBall(pos* ball)
+{
+    ball->x = config.width / 2;
+    ball->y = config.length / 2;
+    if (ball->x > config.length - 1) ball->x = config.length - 1;
+    if (ball->y > config.width - 1) ball->y = config.width - 1;
+}
+
+void moveTo(pos target, football_player* player)
+{
+    player->final.x = target.x;
+    player->final.y = target.y;
+}
+
+void printPlayerInfo(football_player player[]) 
+{
+    int p;
+    // FP0 comes first, then every player
+    for (p = 0; p <= config.numPlayers; p++)
+    {
+        if (isTeamA(player[p].id))
+        {
+            printf("%d ", player[p].id - config.numFields);
+        }
+        if (isTeamB(player[p].id))
+        {
+            printf("%d ", player[p].id - config.numFields - config.teamSize);
+        }
+        if (isPlayerProcess(player[p].id)) 
+        {
+            printf("%d %d ", player[p].initial.x, player[p].initial.y);
+            printf("%d %d ", player[p].final.x, player[p].final.y);
+            printf("%d ", player[p].reached);
+            printf("%d ", player[p].kicked);
+            printf("%d ", player[p].challenge);
+            printf("\n");
+        }
+    }
+}
+
+void getPlayerLine(football_player player, int values[])
+{
+    values[0] = player.id - config.numFields - (isTeamA(player.id) ? 0 : config.teamSize);
+    values[1] = player.initial.x;
+    values[2] = player.initial.y;
+    values[3] = player.final.x;
+    values[4] = player.final.y;
+    values[5] = player.reached;
+    values[6] = player.kicked;
+    values[7] = player.challenge;
+}
+
+void getPlayerLines(football_player player[], int values[])
+{
+    int p, line = 0;
+    for (p = 0; p <= config.numPlayers; p++)
+    {
+        if (isPlayerProcess(player[p].id)) getPlayerLine(player[p], &values[line++ * matchLayout.fields]);
+    }
+}
+
+void startHalf(int worldRank, rand_stream* rng, football_player* player) 
+{
+    pos target;
+    getRandomPos(worldRank, rng, &target);
+    player->final.x = target.x;
+    player->final.y = target.y;
+    player->initial.x = player->final.x;
+    player->initial.y = player->final.y;
+    
+}
+
+void startRound(football_player* player)
+{
+    player->initial.x = player->final.x;
+    player->initial.y = player->final.y;
+    player->kicked = 0;
+    player->reached = 0;
+    player->challenge = -1;
+}
@@ -0,0 +1,123 @@
+#ifndef MATCH_GAME_H
+#define MATCH_GAME_H
+
+#include "binary_trace.h"
+#include "rng.h"
+
+#define DEBUG 0
+#define FALSE 0
+#define TRUE 1
+
+#define LEFT_GOAL -1
+#define RIGHT_GOAL 1
+#define NO_GOAL 0
+
+#define NO_WINNER -1
+
+// a player moves at most this far per axis in a round, see tryToReach, and
+// reaches the ball with at most this many moves, see isWithinRange
+#define MAX_STEP 10
+
+// the defaults are the original 96 x 128 field split into 3 x 4 cells
+#define DEFAULT_WIDTH 96
+#define DEFAULT_LENGTH 128
+#define DEFAULT_ROUNDS 2700
+#define DEFAULT_FIELD_ROWS 3
+#define DEFAULT_FIELD_COLS 4
+#define DEFAULT_TEAM_SIZE 11
+#define DEFAULT_GOAL_WIDTH 9
+
+// options every match program accepts, see parseConfigOption
+#define CONFIG_OPTIONS "c:W:L:N:G:T:g:R:"
+#define CONFIG_USAGE "[-c config] [-W width] [-L length] [-N rounds] [-G rowsxcols] [-T team size] [-g goal width] [-R libc|philox]"
+
+// Ranks 0..numFields-1 own a cell each, then come team A and team B.
+// x runs along the length and y across the width.
+typedef struct
+{
+    int width;
+    int length;
+    int rounds;             // rounds per half
+    int fieldRows;          // cells across the width
+    int fieldCols;          // cells along the length
+    int teamSize;
+    int goalWidth;
+    int rng;                // RNG_LIBC or RNG_PHILOX
+
+    // derived by finishConfig
+    int numFields;
+    int numPlayers;
+    int numProcesses;
+    int goalLow, goalHigh;  // goal mouth, centred on the goal line
+} match_config;
+
+extern match_config config;
+
+typedef struct
+{
+    int x;
+    int y;
+} pos;
+
+typedef struct
+{
+    int id;         // player id
+    pos initial;    // initial pos
+    pos final;      // final pos
+
+    int reached;
+    int kicked;
+    int challenge;
+
+    // attributes
+    int speed;
+    int dribbling;
+    int kick;
+} football_player;
+
+// configuration
+int parseConfigOption(int opt, char* arg);
+int loadConfig(char* path);
+const char* finishConfig(void);
+
+void initField(int* goalA, int* goalB, pos* ball);
+void initPlayers(int world_rank, rand_stream* rng, football_player* player);
+
+// identifiers
+int isFieldProcess(int worldRank);
+int isPlayerProcess(int worldRank);
+int isTeamA(int worldRank);
+int isTeamB(int worldRank);
+int isFP0(int worldRank);
+int isGoal(pos ball);
+int isBallWithinRange(pos ball, football_player player);
+int isWithinRange(int x, int y, int targetX, int targetY, int speed);
+
+// helper functions
+int getFieldProcess(pos player);
+int cellStart(int cell, int extent, int cells);
+int cellIndex(int coord, int extent, int cells);
+void seedEntity(rand_stream* rng, int seed, int worldRank);
+void getRandomPos(int worldRank, rand_stream* rng, pos* target);
+int stepTowards(int from, int to, int movesLeft);
+void tryToReach(pos target, football_player* player);
+void incrementScore(pos ball, int goalA, int goalB, int* Ascore, int* Bscore);
+void swapGoals(int* goalA, int* goalB);
+int rollChallenge(rand_stream* rng, int dribbling);
+void aimBall(pos* target, football_player player, int goal, rand_stream* rng);
+void aimAtGoal(pos* target, pos from, int kick, int goal);
+void kickBall(pos target, pos* ball);
+void resetBall(pos* ball);
+void moveTo(pos target, football_player* player);
+
+// print functions
+void printPlayerInfo(football_player players[]);
+// the ints of the lines printPlayerInfo prints, matchLayout.fields per player
+void getPlayerLine(football_player player, int values[]);
+void getPlayerLines(football_player players[], int values[]);
+
+// facades
+void startHalf(int worldRank, rand_stream* rng, football_player* player);
+void startRound(football_player* player);
+
+#endif
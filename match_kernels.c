@@ -0,0 +1,91 @@
+#include "match_kernels.h"
+
+static inline int minInt(int a, int b)
+{
+    return a < b ? a : b;
+}
+
+static inline int maxInt(int a, int b)
+{
+    return a > b ? a : b;
+}
+
+static inline int clampInt(int value, int low, int high)
+{
+    return minInt(maxInt(value, low), high);
+}
+
+static inline int absInt(int value)
+{
+    return maxInt(value, -value);
+}
+
+// isWithinRange spends |dx| and then |dy| out of min(speed, 10) and needs
+// both to be strictly less than what is left, i.e. |dx| + |dy| < moves
+void ballWithinRangeBatch(int n, const int* restrict x, const int* restrict y, const int* restrict speed, pos ball,
+    int* restrict inRange)
+{
+    int p;
+    #pragma omp simd
+    for (p = 0; p < n; p++)
+    {
+        int moves = minInt(speed[p], MAX_STEP);
+        inRange[p] = absInt(x[p] - ball.x) + absInt(y[p] - ball.y) < moves;
+    }
+}
+
+// compares against the bounds of the ball's cell instead of looking up
+// the cell of every player
+void inBallFieldBatch(int n, const int* restrict x, const int* restrict y, pos ball, int* restrict inField)
+{
+    int p;
+    int col = cellIndex(ball.x, config.length, config.fieldCols);
+    int row = cellIndex(ball.y, config.width, config.fieldRows);
+    int left = cellStart(col, config.length, config.fieldCols);
+    int right = cellStart(col + 1, config.length, config.fieldCols);
+    int top = cellStart(row, config.width, config.fieldRows);
+    int bottom = cellStart(row + 1, config.width, config.fieldRows);
+
+    #pragma omp simd
+    for (p = 0; p < n; p++)
+    {
+        inField[p] = (x[p] >= left) & (x[p] < right) & (y[p] >= top) & (y[p] < bottom);
+    }
+}
+
+// stepTowards moves by the difference clamped to [-moves, moves]
+void tryToReachBatch(int n, const int* restrict fromX, const int* restrict fromY, const int* restrict targetX,
+    const int* restrict targetY, const int* restrict speed, int* restrict toX, int* restrict toY)
+{
+    int p;
+    #pragma omp simd
+    for (p = 0; p < n; p++)
+    {
+        int moves = minInt(speed[p], MAX_STEP);
+        toX[p] = fromX[p] + clampInt(targetX[p] - fromX[p], -moves, moves);
+        toY[p] = fromY[p] + clampInt(targetY[p] - fromY[p], -moves, moves);
+    }
+}
+
+// x goes towards the goal line first, then y spends the rest of 2 * kick
+// getting inside the goal mouth
+void aimAtGoalBatch(int n, const int* restrict x, const int* restrict y, const int* restrict kick,
+    const int* restrict goal, int* restrict targetX, int* restrict targetY)
+{
+    int p;
+    int lastX = config.length - 1;
+    int goalLow = config.goalLow;
+    int goalHigh = config.goalHigh;
+
+    #pragma omp simd
+    for (p = 0; p < n; p++)
+    {
+        int moves = kick[p] * 2;
+        int lineX = (goal[p] == LEFT_GOAL) ? 0 : lastX;
+        int moveX = clampInt(lineX - x[p], -moves, moves);
+        moves -= absInt(moveX);
+        int moveY = clampInt(clampInt(y[p], goalLow, goalHigh) - y[p], -moves, moves);
+        targetX[p] = x[p] + moveX;
+        targetY[p] = y[p] + moveY;
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef MATCH_KERNELS_H
+#define MATCH_KERNELS_H
+
+#include "match_game.h"
+
+// Batch versions of the movement rules over struct-of-arrays player state.
+// Each kernel gives the same result as calling the rule in match_game.c
+// once per player, but uses branch-free min/max arithmetic in an omp simd
+// loop so the compiler vectorises it (needs -fopenmp-simd or -fopenmp).
+
+// isBallWithinRange: 1 if the player can step onto the ball this round
+void ballWithinRangeBatch(int n, const int* x, const int* y, const int* speed, pos ball, int* inRange);
+
+// 1 if the player stands in the field cell that holds the ball
+void inBallFieldBatch(int n, const int* x, const int* y, pos ball, int* inField);
+
+// tryToReach: each axis moves at most min(speed, 10) towards its target
+void tryToReachBatch(int n, const int* fromX, const int* fromY, const int* targetX, const int* targetY,
+    const int* speed, int* toX, int* toY);
+
+// aimAtGoal, the deterministic part of aimBall, for n kickers
+void aimAtGoalBatch(int n, const int* x, const int* y, const int* kick, const int* goal, int* targetX, int* targetY);
+
+#endif
@@ -0,0 +1,138 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "match_live.h"
+
+static live_round* liveSlot(live_header* header, unsigned long n)
+{
+    return (live_round*) ((char*) (header + 1) + (size_t) (n % LIVE_SLOTS) * header->slotSize);
+}
+
+const char* openLive(match_live* live, const char* name)
+{
+    int slotSize = sizeof(live_round) + config.numPlayers * sizeof(pos);
+    slotSize = (slotSize + 7) & ~7;
+    snprintf(live->name, sizeof(live->name), "%s", name);
+    live->published = 0;
+    live->size = sizeof(live_header) + (size_t) LIVE_SLOTS * slotSize;
+
+    // viewers still on a segment of an earlier run keep theirs
+    shm_unlink(live->name);
+    int fd = shm_open(live->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) return "cannot create the shared memory";
+    if (ftruncate(fd, live->size) != 0)
+    {
+        close(fd);
+        shm_unlink(live->name);
+        return "cannot size the shared memory";
+    }
+    live->header = mmap(NULL, live->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (live->header == MAP_FAILED)
+    {
+        shm_unlink(live->name);
+        return "cannot map the shared memory";
+    }
+
+    // the segment starts zeroed, so every slot is free and nothing is published
+    live_header* header = live->header;
+    header->numPlayers = config.numPlayers;
+    header->width = config.width;
+    header->length = config.length;
+    header->rounds = config.rounds;
+    header->slotSize = slotSize;
+    memcpy(header->magic, LIVE_MAGIC, sizeof(header->magic));
+    atomic_store_explicit(&header->state, LIVE_RUNNING, memory_order_release);
+    return NULL;
+}
+
+void publishLive(match_live* live, int half, int round, pos ball, int Ascore, int Bscore, football_player players[])
+{
+    int p;
+    unsigned long n = live->published;
+    live_round* slot = liveSlot(live->header, n);
+    pos* positions = (pos*) (slot + 1);
+
+    // odd while the slot is being written over
+    atomic_store_explicit(&slot->sequence, 2 * n + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->half = half;
+    slot->round = round;
+    slot->ballX = ball.x;
+    slot->ballY = ball.y;
+    slot->Ascore = Ascore;
+    slot->Bscore = Bscore;
+    for (p = 0; p < live->header->numPlayers; p++) positions[p] = players[p].final;
+    atomic_store_explicit(&slot->sequence, 2 * n + 2, memory_order_release);
+
+    live->published = n + 1;
+    atomic_store_explicit(&live->header->published, n + 1, memory_order_release);
+}
+
+void closeLive(match_live* live)
+{
+    atomic_store_explicit(&live->header->state, LIVE_FINISHED, memory_order_release);
+    munmap(live->header, live->size);
+    shm_unlink(live->name);
+}
+
+const char* attachLive(match_live* live, const char* name)
+{
+    struct stat info;
+    snprintf(live->name, sizeof(live->name), "%s", name);
+    int fd = shm_open(live->name, O_RDONLY, 0);
+    if (fd < 0) return "no match is running";
+
+    // the segment can be seen before FP0 has sized it
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(live_header))
+    {
+        close(fd);
+        return "the match is still starting";
+    }
+    live->size = info.st_size;
+    live->header = mmap(NULL, live->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (live->header == MAP_FAILED) return "cannot map the shared memory";
+
+    live_header* header = live->header;
+    if (atomic_load_explicit(&header->state, memory_order_acquire) == 0 ||
+        memcmp(header->magic, LIVE_MAGIC, sizeof(header->magic)) != 0)
+    {
+        munmap(live->header, live->size);
+        return "the match is still starting";
+    }
+    if (live->size < sizeof(live_header) + (size_t) LIVE_SLOTS * header->slotSize)
+    {
+        munmap(live->header, live->size);
+        return "not a live match";
+    }
+    return NULL;
+}
+
+int readLive(match_live* live, unsigned long n, live_round* round, pos positions[])
+{
+    live_round* slot = liveSlot(live->header, n);
+    unsigned long sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != 2 * n + 2) return 0;
+
+    round->half = slot->half;
+    round->round = slot->round;
+    round->ballX = slot->ballX;
+    round->ballY = slot->ballY;
+    round->Ascore = slot->Ascore;
+    round->Bscore = slot->Bscore;
+    memcpy(positions, slot + 1, live->header->numPlayers * sizeof(pos));
+
+    // FP0 may have started on the slot again while it was copied
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->sequence, memory_order_relaxed) == sequence;
+}
+
+void detachLive(match_live* live)
+{
+    munmap(live->header, live->size);
+}
@@ -0,0 +1,67 @@
+#ifndef MATCH_LIVE_H
+#define MATCH_LIVE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "match_game.h"
+
+// Live telemetry. FP0 publishes every round it reports into a ring in
+// POSIX shared memory, and viewers map it read only, so they can come and
+// go without the match ever waiting on them. Each slot is a sequence lock:
+// round n of the run is in slot n % LIVE_SLOTS, with sequence 2n + 1 while
+// FP0 writes it and 2n + 2 once it is complete. A viewer copies a slot and
+// keeps the copy only if the sequence was 2n + 2 before and after, so a
+// viewer that falls more than LIVE_SLOTS rounds behind loses rounds rather
+// than holding up the match.
+
+#define LIVE_MAGIC "MLIVE01"
+#define LIVE_SLOTS 64
+#define LIVE_DEFAULT "/match_live"
+
+// states of the producer
+#define LIVE_RUNNING 1
+#define LIVE_FINISHED 2
+
+typedef struct
+{
+    char magic[8];
+    int numPlayers;
+    int width, length;
+    int rounds;                         // per half
+    int slotSize;                       // bytes, the positions included
+    atomic_int state;
+    atomic_ulong published;             // rounds in the ring so far
+} live_header;
+
+typedef struct
+{
+    atomic_ulong sequence;
+    int half, round;
+    int ballX, ballY;
+    int Ascore, Bscore;
+} live_round;                           // followed by a pos per player
+
+typedef struct
+{
+    char name[64];
+    size_t size;
+    live_header* header;
+    unsigned long published;            // the producer's count
+} match_live;
+
+// FP0 creates the segment, replacing one left by an earlier run
+const char* openLive(match_live* live, const char* name);
+// players in trace order, only their final positions are published
+void publishLive(match_live* live, int half, int round, pos ball, int Ascore, int Bscore, football_player players[]);
+// marks the match finished for the viewers and removes the name, viewers
+// already attached keep their mapping
+void closeLive(match_live* live);
+
+// viewers map an existing segment read only
+const char* attachLive(match_live* live, const char* name);
+// round n of the run, 0 if it is not there yet or the ring has moved past it
+int readLive(match_live* live, unsigned long n, live_round* round, pos positions[]);
+void detachLive(match_live* live);
+
+#endif
@@ -2,336 +2,790 @@
 #include <stdio.h>
 #include <time.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "match_balance.h"
+#include "match_checkpoint.h"
+#include "match_engine.h"
+#include "match_game.h"
+#include "match_live.h"
+#include "match_wire.h"
+#include "mpi_profile.h"
+#include "parallel_trace.h"
+#include "trace_writer.h"
 
-#define DEBUG 0
-#define FALSE 0
-#define TRUE 1
-
-#define LEFT_GOAL -1
-#define RIGHT_GOAL 1
-#define NO_GOAL 0
-
-#define NO_WINNER -1
-
-#define WIDTH 96
-#define LENGTH 128
-#define NUM_ROUNDS 2700 
+int field, tag;
+rand_stream rng;
+
+#define TAG_BALL 0
+#define TAG_MOVE 1
+#define TAG_CHALLENGE 2
+#define TAG_WINNER 3
+
+// a field rank can hand players to any other, so each gets a block that
+// has room for every player as rank, x and y
+#define HANDOFF_SIZE (3 * config.numPlayers)
+
+// a new cut of the field is only taken if the busiest rank is left with
+// less than this percentage of its load, so ranks do not trade tiles back and forth
+#define REBALANCE_KEEP 90
+
+// round protocols
+#define PROTOCOL_CART 0     // field ranks own their cell's players and the ball
+#define PROTOCOL_FUSED 1    // players resolve the round with a single reduction
+#define PROTOCOL_HOSTED 2   // the fused protocol with blocks of players on any number of ranks
+
+// reporting modes
+#define REPORT_SYNC 0       // FP0 gathers and prints each round before anyone moves on
+#define REPORT_ASYNC 1      // round r is gathered and printed while round r+1 is played
+
+// profiling phases, see mpi_profile.h
+#define PHASE_SETUP 0
+#define PHASE_ASSIGN 1      // rebuilding cell membership at kick-off
+#define PHASE_SERVE 2       // cells sending the ball to their players
+#define PHASE_MOVE 3        // moving and handing players to other cells
+#define PHASE_CHALLENGE 4   // challenges, the winner and its kick
+#define PHASE_BALL 5        // sharing the new ball and the score
+#define PHASE_REPORT 6      // gathering rounds on FP0
+#define PHASE_PRINT 7
+#define PHASE_CHECKPOINT 8
+#define PHASE_BALANCE 9     // moving tiles between field ranks
+#define PHASE_STATS 10      // putting the -a tallies together on FP0
+#define NUM_PHASES 11
 
 typedef struct
 {
-    int x;
-    int y;
-} pos;
+    int count;
+    int* rank;              // room for every player
+    pos* position;
+} field_members;
 
 typedef struct
 {
-    int id;         // player id
-    pos initial;    // initial pos 
-    pos final;      // final pos
-
-    int reached;
-    int kicked;
-    int challenge;
+    int count;
+    int* rank;              // field ranks owning tiles in reach of ours
+    int* handoff;           // one block of HANDOFF_SIZE per neighbour
+    int* arrivals;
+    int* leaving;           // players handed to each neighbour this round
+    int* coming;            // and from each
+    int* sent;              // ints to and from each neighbour, and where their blocks start
+    int* received;
+    int* displs;
+} field_neighbours;
 
-    // attributes
-    int speed;
-    int dribbling;
-    int kick;
-} football_player;
-
-int field, tag;
-
-void initField(int world_rank, int* goalA, int* goalB, pos* ball);
-void initPlayers(int world_rank, football_player* player);
+typedef struct
+{
+    int protocol;
+    int report;
+    int seed;
+    int every;                  // checkpoint interval in rounds, 0 for none
+    char* checkpoint;
+    char* restart;              // checkpoint to resume from, or NULL
+    int rebalance;              // rounds between cutting the field again, 0 for never
+    int tileRows, tileCols;     // tile grid, the cells by default
+    int output;
+    char* tracePath;            // every reporting rank writes its part there, or NULL
+    int writerThread;           // FP0 formats and writes the trace on a thread of its own
+    char* summaryPath;          // FP0 writes the statistics of the run there, or NULL
+    char* liveName;             // FP0 publishes the rounds to viewers there, or NULL
+} match_options;
+
+// Double buffered snapshots of the rounds on their way to FP0, packed as
+// in match_wire.h
+typedef struct
+{
+    int mode;
+    int next;                   // slot the next round goes into
+    int pending[2];
+    int half[2], round[2];
+    pos ball[2];
+    int score[2][2];                // A and B after the round
+    MPI_Request request[2];
+    unsigned char sent[2][MAX_WIRE_SIZE];
+    unsigned char* packed[2];       // FP0's, a record per reporting rank
+    football_player* players;       // what FP0 knows of itself and every player
+    int gather;                     // rounds go to FP0, not with -w or -o none alone
+    trace_writer* writer;           // FP0's
+    parallel_trace* parallel;       // instead of the writer with -w
+    match_live* live;               // FP0's, with -l
+} match_reports;
 
-// identifiers
-int isFieldProcess(int worldRank);
-int isPlayerProcess(int worldRank);
-int isTeamA(int worldRank);
-int isTeamB(int worldRank);
-int isFP0(int worldRank);
-int isGoal(pos ball);
-int isBallWithinRange(pos ball, football_player player);
+typedef struct
+{
+    int worldRank;
+    int protocol;
+    int rebalance;
+    int field;                  // field the player currently belongs to
+    int owner;                  // field rank serving the player's tile
+    football_player player;
+    pos ball;
+    int goalA, goalB;
+    int Ascore, Bscore;
+
+    MPI_Comm field_comm, reporting_comm, neighbour_comm, play_comm;
+    MPI_Datatype mpi_ball, mpi_player;
+    field_neighbours neighbours;
+    field_members members;
+    field_tiles tiles;
+    int* kick;                  // kick attribute of every rank
+    match_reports reports;
+    match_tally tally;          // the player's own, with -a
+    match_summary* summary;     // FP0's
+} match_state;
+
+void parseOptions(int argc, char **argv, int worldRank, int worldSize, match_options* options);
+trace_writer* openOutput(match_options* options, int worldRank);
+void closeOutput(trace_writer* writer);
+parallel_trace* openParallelOutput(match_options* options, MPI_Comm comm);
+match_live* openLiveOutput(match_options* options, int worldRank);
+void closeLiveOutput(match_live* live);
+void closeParallelOutput(parallel_trace* parallel);
+match_summary* openSummary(match_options* options, int worldRank);
+void closeSummary(match_options* options, match_summary* summary);
+void allocateState(match_state* state);
+void freeState(match_state* state);
+
+// round protocols
+void playCartRound(match_state* state);
+void playFusedRound(match_state* state);
+void playHostedMatch(match_options* options, int worldRank, int worldSize);
 
 // helper functions
-int getFieldProcess(pos player);
-void getRandomPos(int worldRank, pos* target);
-void tryToReach(pos target, football_player* player);
-void incrementScore(pos ball, int goalA, int goalB, int* Ascore, int* Bscore);
-void groupFieldAndPlayers(int worldRank, football_player player, int* field, MPI_Comm* subfield_comm);
 void groupAllFieldProcesses(int worldRank, MPI_Comm* field_comm);
 void groupFP0AndPlayers(int worldRank, MPI_Comm* reporting_comm);
-void swapGoals(int* goalA, int* goalB);
-void challengeBall(int worldRank, int challenge[2]);
-void aimBall(pos* target, football_player player, int goal);
-void kickBall(pos target, pos* ball);
-void moveTo(pos target, football_player* player);
-void handleFieldWithBall(int worldRank, football_player* player, pos* ball, MPI_Comm subfield_comm, MPI_Datatype mpi_ball, int goalA, int goalB);
+void groupPlayers(int worldRank, MPI_Comm* play_comm);
+void createFieldTopology(int worldRank, MPI_Comm field_comm, field_tiles* tiles, MPI_Comm* neighbour_comm, field_neighbours* neighbours);
+void assignMembers(int worldRank, football_player player, MPI_Datatype mpi_ball, field_tiles* tiles, field_members* members);
+void addMember(field_members* members, int rank, pos position);
+void serveBall(field_members* members, pos ball, MPI_Datatype mpi_ball);
+void handOffPlayers(int worldRank, field_tiles* tiles, field_members* members, field_neighbours* neighbours, MPI_Comm neighbour_comm, MPI_Datatype mpi_ball);
+void measureLoad(field_tiles* tiles, field_members* members, pos ball);
+void rebalanceField(match_state* state);
+void movePlayer(match_state* state, int fieldWithBall);
+void challengeBall(int worldRank, int field, football_player* player, MPI_Datatype mpi_ball, int goalA, int goalB);
+void handleFieldWithBall(field_members* members, pos* ball, MPI_Datatype mpi_ball);
+void updateScore(match_state* state);
+void followBall(match_state* state, football_player players[]);
+
+// checkpoints
+void saveMatch(match_state* state, match_options* options, int half, int round, int tick);
+void restoreMatch(match_state* state, char* path, int* half, int* round, int* tick);
+void saveHosted(match_engine* engine, match_options* options, trace_writer* writer, parallel_trace* parallel, int worldRank, int counts[], int displs[], int half, int round);
+void restoreHosted(match_engine* engine, char* path, int worldRank, int counts[], int displs[], int* half, int* round);
 
 // print functions
-void printPlayerInfo(football_player players[23]);
-void printFieldGroups(int worldRank, int worldSize, MPI_Comm subfield_comm);
+void printFieldMembers(int worldRank, field_members* members);
+void startReports(match_state* state);
+void reportRound(match_state* state, int half, int round);
+void reportPart(match_state* state, int round);
+void completeReport(match_state* state, int slot);
+void flushReports(match_state* state);
 
-// facades
-void startHalf(int worldRank, football_player* player);
-void startRound(football_player* player);
+// in-situ statistics, see match_stats.h
+void combineHalf(MPI_Comm comm, match_tally* tally, match_summary* summary, int half, int Ascore, int Bscore);
+void combinePlayers(MPI_Comm comm, match_tally* tally, match_summary* summary);
 
 void createBallStruct(MPI_Datatype* mpi_ball);
 void createPlayerStruct(MPI_Datatype mpi_ball, MPI_Datatype* mpi_player);
 
 int main(int argc, char **argv)
 {
-    int worldSize, worldRank;
-    MPI_Init(NULL, NULL);
+    int worldSize, worldRank, provided;
+    // only the main thread makes MPI calls, the trace writer makes none
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_size(MPI_COMM_WORLD, &worldSize);
     MPI_Comm_rank(MPI_COMM_WORLD, &worldRank);
+    const char* phaseNames[NUM_PHASES] = {"setup", "assign", "serve", "move", "challenge", "ball", "report", "print", "checkpoint", "balance", "stats"};
+    profilePhases(phaseNames, NUM_PHASES);
 
     int round, half;
-    int field, winner;
-    int playerChangeField = 0;
-    int goalA, goalB;
-    int Ascore = 0;
-    int Bscore = 0;
-
-    srand(worldRank);
-    
-    pos ball;
-    MPI_Datatype mpi_ball;
-    createBallStruct(&mpi_ball);
-
-    football_player player;
-    MPI_Datatype mpi_player;
-    createPlayerStruct(mpi_ball, &mpi_player);
-
-    player.id = worldRank;
-    initField(worldRank, &goalA, &goalB, &ball);
-    initPlayers(worldRank, &player);
-
-    MPI_Comm field_comm, reporting_comm, subfield_comm;
-    groupAllFieldProcesses(worldRank, &field_comm);
-    groupFP0AndPlayers(worldRank, &reporting_comm);
-    
-    for (half = 0; half < 2; half++) {
-        swapGoals(&goalA, &goalB);
-        startHalf(worldRank, &player);
-        groupFieldAndPlayers(worldRank, player, &field, &subfield_comm);
-        for (round = 0; round < NUM_ROUNDS; round++) {
-            startRound(&player);
-            // get ball position from field process
-            MPI_Bcast(&ball, 1, mpi_ball, 0, subfield_comm);
-            int fieldWithBall = getFieldProcess(ball);
-
-            playerChangeField = FALSE;
-            if (isPlayerProcess(worldRank))
-            {
-                
-               if (field == fieldWithBall)
-               {
-                   // run after ball
-                   tryToReach(ball, &player);
-               }
-               else if (isBallWithinRange(ball, player)) 
-               {
-                   // check if ball is within range
-                   moveTo(ball, &player);
-               } 
-               else {
-                   // move to default position
-                   pos target;
-                   getRandomPos(worldRank, &target);
-                   tryToReach(target, &player);
-               }
-               // check if field changed
-               if (field != getFieldProcess(player.final))
-               {
-                    playerChangeField = TRUE;
-               }
-            }
+    int tick = 0;               // random round: 0 at set-up, then each kick-off and round
+    int firstHalf = 0, firstRound = 0;
+    match_options options;
+    match_state state;
+    parseOptions(argc, argv, worldRank, worldSize, &options);
+    options.writerThread = (provided >= MPI_THREAD_FUNNELED);
+    if (options.protocol == PROTOCOL_HOSTED)
+    {
+        playHostedMatch(&options, worldRank, worldSize);
+        MPI_Finalize();
+        return 0;
+    }
 
-            int p;
-            int playersFieldChange[34];
-            MPI_Allgather(&playerChangeField, 1, MPI_INT, &playersFieldChange, 1, MPI_INT, MPI_COMM_WORLD);
-            for (p = 0; p < 34; p++) 
-            {
-                if (playersFieldChange[p] != FALSE) 
-                {
-                    playerChangeField = TRUE;
-                }
-            }
-            // comm now outdated; regroup into new comm
-            if (playerChangeField) {
-                MPI_Comm_free(&subfield_comm);
-                groupFieldAndPlayers(worldRank, player, &field, &subfield_comm);
-            }
+    // seed s gives every rank the stream match_smp -s s gives that player
+    seedEntity(&rng, options.seed, worldRank);
+
+    state.worldRank = worldRank;
+    state.protocol = options.protocol;
+    state.rebalance = options.rebalance;
+    state.Ascore = 0;
+    state.Bscore = 0;
+    createBallStruct(&state.mpi_ball);
+    createPlayerStruct(state.mpi_ball, &state.mpi_player);
+
+    state.player.id = worldRank;
+    initField(&state.goalA, &state.goalB, &state.ball);
+    initPlayers(worldRank, &rng, &state.player);
+
+    groupAllFieldProcesses(worldRank, &state.field_comm);
+    groupFP0AndPlayers(worldRank, &state.reporting_comm);
+    memset(&state.reports, 0, sizeof(state.reports));
+    state.reports.mode = options.report;
+    state.reports.gather = (options.tracePath == NULL && (options.output != OUTPUT_NONE || options.liveName != NULL));
+    state.reports.writer = openOutput(&options, worldRank);
+    state.reports.live = openLiveOutput(&options, worldRank);
+    state.summary = openSummary(&options, worldRank);
+    if (options.summaryPath != NULL) initTally(&state.tally, isPlayerProcess(worldRank) ? 1 : 0);
+    if (isFP0(worldRank) || isPlayerProcess(worldRank)) state.reports.parallel = openParallelOutput(&options, state.reporting_comm);
+    allocateState(&state);
+    initTiles(&state.tiles, options.tileRows, options.tileCols);
+    if (options.restart != NULL) restoreMatch(&state, options.restart, &firstHalf, &firstRound, &tick);
+    if (options.protocol == PROTOCOL_CART && isFieldProcess(worldRank))
+    {
+        createFieldTopology(worldRank, state.field_comm, &state.tiles, &state.neighbour_comm, &state.neighbours);
+    }
+    if (options.protocol == PROTOCOL_FUSED)
+    {
+        // attributes never change, so every rank learns them once
+        MPI_Allgather(&state.player.kick, 1, MPI_INT, state.kick, 1, MPI_INT, MPI_COMM_WORLD);
+        // FP0 follows the ball from the reports, so only players play the round
+        groupPlayers(worldRank, &state.play_comm);
+        if (!isFP0(worldRank) && !isPlayerProcess(worldRank))
+        {
+            // the other field ranks have no part in the fused protocol
+            MPI_Comm_free(&state.reporting_comm);
+            MPI_Comm_free(&state.field_comm);
+            freeTiles(&state.tiles);
+            freeState(&state);
+            MPI_Finalize();
+            return 0;
+        }
+    }
 
-            // Field with ball will handle ball challenges
-            if (field == fieldWithBall)
+    startReports(&state);
+    for (half = firstHalf; half < 2; half++) {
+        if (half != firstHalf || firstRound == 0)
+        {
+            swapGoals(&state.goalA, &state.goalB);
+            setRandomRound(&rng, ++tick);
+            startHalf(worldRank, &rng, &state.player);
+        }
+        if (options.protocol == PROTOCOL_CART)
+        {
+            // players are scattered over the whole field, so membership is rebuilt from scratch
+            PROFILE_PHASE(PHASE_ASSIGN);
+            assignMembers(worldRank, state.player, state.mpi_ball, &state.tiles, &state.members);
+        }
+        state.field = isFieldProcess(worldRank) ? worldRank : getFieldProcess(state.player.final);
+        state.owner = getOwner(&state.tiles, state.player.final);
+        for (round = (half == firstHalf ? firstRound : 0); round < config.rounds; round++) {
+            setRandomRound(&rng, ++tick);
+            startRound(&state.player);
+            if (options.protocol == PROTOCOL_CART) playCartRound(&state);
+            else playFusedRound(&state);
+            if (options.rebalance > 0 && (round + 1) % options.rebalance == 0 && round + 1 < config.rounds)
             {
-                handleFieldWithBall(worldRank, &player, &ball, subfield_comm, mpi_ball, goalA, goalB);
+                PROFILE_PHASE(PHASE_BALANCE);
+                rebalanceField(&state);
             }
 
-            // field with ball broadcasts new ball position to all fields
-            if (isFieldProcess(worldRank))
+            PROFILE_PHASE(PHASE_REPORT);
+            if (options.summaryPath != NULL && isPlayerProcess(worldRank))
             {
-                MPI_Bcast(&ball, 1, mpi_ball, fieldWithBall, field_comm);
-                if (isGoal(ball))
-                {
-                    // increment score
-                    incrementScore(ball, goalA, goalB, &Ascore, &Bscore);
-                    // reset ball position
-                    ball.x = WIDTH / 2;
-                    ball.y = LENGTH / 2;
-                }
+                // a kick always lands where it is aimed, so the kicker knows if it scored
+                football_player* player = &state.player;
+                pos target;
+                aimAtGoal(&target, player->final, player->kick, isTeamA(worldRank) ? state.goalA : state.goalB);
+                tallyPlayer(&state.tally, 0, isTeamA(worldRank) ? 0 : 1, round, player->initial.x, player->initial.y,
+                    player->final.x, player->final.y, player->reached, player->kicked, player->kicked && isGoal(target));
             }
-
-            // all players send their position to field 0 
-            if (isFP0(worldRank) || isPlayerProcess(worldRank))
+            reportRound(&state, half, round);
+            if (options.every > 0 && (round + 1) % options.every == 0 && round + 1 < config.rounds)
             {
-                football_player players[23];
-                MPI_Gather(&player, 1, mpi_player, &players, 1, mpi_player, 0, reporting_comm);
-                if (isFP0(worldRank)) 
-                {
-                    printf("%d\n", round);
-                    printf("%d %d\n", ball.x, ball.y);
-                    printPlayerInfo(players);
-                }
+                saveMatch(&state, &options, half, round + 1, tick);
             }
-
-            MPI_Barrier(MPI_COMM_WORLD);
         }
-	if (DEBUG) if (isFP0(worldRank)) printf("Half-time score: A %d:%d B\n", Ascore, Bscore);
+        flushReports(&state);
+        if (options.summaryPath != NULL && (isFP0(worldRank) || isPlayerProcess(worldRank)))
+        {
+            combineHalf(state.reporting_comm, &state.tally, state.summary, half, state.Ascore, state.Bscore);
+        }
+        if (options.every > 0 && half == 0) saveMatch(&state, &options, 1, 0, tick);
+	if (DEBUG) if (isFP0(worldRank)) printf("Half-time score: A %d:%d B\n", state.Ascore, state.Bscore);
+    }
+    if (DEBUG) if (isFP0(worldRank)) printf("Final score: A %d:%d B\n", state.Ascore, state.Bscore);
+
+    if (options.protocol == PROTOCOL_CART && isFieldProcess(worldRank)) MPI_Comm_free(&state.neighbour_comm);
+    if (options.protocol == PROTOCOL_FUSED && isPlayerProcess(worldRank)) MPI_Comm_free(&state.play_comm);
+    closeOutput(state.reports.writer);
+    closeParallelOutput(state.reports.parallel);
+    closeLiveOutput(state.reports.live);
+    if (options.summaryPath != NULL && (isFP0(worldRank) || isPlayerProcess(worldRank)))
+    {
+        combinePlayers(state.reporting_comm, &state.tally, state.summary);
+        closeSummary(&options, state.summary);
+        freeTally(&state.tally);
     }
-    if (DEBUG) if (isFP0(worldRank)) printf("Final score: A %d:%d B\n", Ascore, Bscore);
-    
-    MPI_Comm_free(&subfield_comm);
-    MPI_Comm_free(&reporting_comm);
-    MPI_Comm_free(&field_comm);
+    MPI_Comm_free(&state.reporting_comm);
+    MPI_Comm_free(&state.field_comm);
+    freeTiles(&state.tiles);
+    freeState(&state);
     MPI_Finalize();
 }
 
-void initField(int worldRank, int* goalA, int* goalB, pos* ball)
+void parseOptions(int argc, char **argv, int worldRank, int worldSize, match_options* options)
 {
-    // Goals will be swapped after this (i.e. goalA = LEFT, goalB = RIGHT)
-    *goalA = RIGHT_GOAL;
-    *goalB = LEFT_GOAL;
-    *goalA = LEFT_GOAL;
-    *goalB = RIGHT_GOAL;
+    int opt;
+    options->protocol = PROTOCOL_FUSED;
+    options->report = REPORT_ASYNC;
+    options->seed = 0;
+    options->every = 0;
+    options->checkpoint = "match.ckpt";
+    options->restart = NULL;
+    options->rebalance = 0;
+    options->tileRows = 0;
+    options->tileCols = 0;
+    options->output = OUTPUT_TEXT;
+    options->tracePath = NULL;
+    options->summaryPath = NULL;
+    options->liveName = NULL;
+    while ((opt = getopt(argc, argv, "p:r:s:k:f:x:b:t:o:w:a:l:" CONFIG_OPTIONS)) != -1)
+    {
+        if (opt == 'p' && strcmp(optarg, "cart") == 0) options->protocol = PROTOCOL_CART;
+        else if (opt == 'p' && strcmp(optarg, "fused") == 0) options->protocol = PROTOCOL_FUSED;
+        else if (opt == 'p' && strcmp(optarg, "hosted") == 0) options->protocol = PROTOCOL_HOSTED;
+        else if (opt == 'r' && strcmp(optarg, "sync") == 0) options->report = REPORT_SYNC;
+        else if (opt == 'r' && strcmp(optarg, "async") == 0) options->report = REPORT_ASYNC;
+        else if (opt == 's') options->seed = atoi(optarg);
+        else if (opt == 'k') options->every = atoi(optarg);
+        else if (opt == 'f') options->checkpoint = optarg;
+        else if (opt == 'x') options->restart = optarg;
+        else if (opt == 'b') options->rebalance = atoi(optarg);
+        else if (opt == 'o' && strcmp(optarg, "text") == 0) options->output = OUTPUT_TEXT;
+        else if (opt == 'o' && strcmp(optarg, "binary") == 0) options->output = OUTPUT_BINARY;
+        else if (opt == 'o' && strcmp(optarg, "none") == 0) options->output = OUTPUT_NONE;
+        else if (opt == 'w') options->tracePath = optarg;
+        else if (opt == 'a') options->summaryPath = optarg;
+        else if (opt == 'l') options->liveName = optarg;
+        else if (opt == 't')
+        {
+            // a malformed grid is caught with the other tile checks
+            if (sscanf(optarg, "%dx%d", &options->tileRows, &options->tileCols) != 2) options->tileRows = -1;
+        }
+        else if (!parseConfigOption(opt, optarg))
+        {
+            if (isFP0(worldRank)) fprintf(stderr, "Usage: %s [-p cart|fused|hosted] [-r sync|async] [-s seed] "
+                "[-k checkpoint every] [-f checkpoint] [-x restart from] [-b rebalance every] [-t tile rowsxcols] "
+                "[-o text|binary|none] [-w trace file] [-a summary] [-l live name] " CONFIG_USAGE "\n", argv[0]);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
 
-    if (isFieldProcess(worldRank)) 
+    const char* error = finishConfig();
+    if (error == NULL && worldSize != config.numProcesses && options->protocol != PROTOCOL_HOSTED)
+    {
+        error = "run one rank per cell and one per player, or use -p hosted";
+    }
+    if (options->tileRows == 0 && options->tileCols == 0)
+    {
+        options->tileRows = config.fieldRows;
+        options->tileCols = config.fieldCols;
+    }
+    if (error == NULL && (options->tileRows < 1 || options->tileRows > config.width ||
+        options->tileCols < 1 || options->tileCols > config.length))
+    {
+        error = "every tile needs to cover part of the field";
+    }
+    if (error == NULL && options->rebalance > 0 && options->protocol != PROTOCOL_CART)
+    {
+        error = "only the cart protocol has field ranks to rebalance";
+    }
+    if (error == NULL && options->tracePath != NULL && options->output == OUTPUT_BINARY)
+    {
+        error = "binary traces are written by FP0 alone, leave out -w";
+    }
+    if (error == NULL && options->tracePath != NULL && options->output == OUTPUT_NONE)
+    {
+        error = "-o none writes no trace, leave out -w";
+    }
+    if (error == NULL && options->tracePath != NULL && options->liveName != NULL)
     {
-        // Ball starts in the center
-        ball->x = LENGTH/2;
-        ball->y = WIDTH/2;
+        error = "live rounds are published by FP0, leave out -w";
+    }
+    if (error != NULL)
+    {
+        if (isFP0(worldRank)) fprintf(stderr, "%s: %s (%d cells + %d players = %d ranks, got %d)\n",
+            argv[0], error, config.numFields, config.numPlayers, config.numProcesses, worldSize);
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
 }
 
-void initPlayers(int worldRank, football_player* player)
+// Only FP0 writes the trace, unless every rank writes its part with -w
+trace_writer* openOutput(match_options* options, int worldRank)
 {
-    // player stats
-    pos target;
-    getRandomPos(worldRank, &target);
-    player->id = worldRank;
-    player->initial.x = target.x;
-    player->initial.y = target.y;
-    player->final.x = player->initial.x;
-    player->final.y = player->initial.y;
-    player->reached = 0;
-    player->kicked = 0;
-    player->challenge = -1;
-    player->speed = 10;
-    player->dribbling = 1;
-    player->kick = 4;
-    
+    if (!isFP0(worldRank) || options->tracePath != NULL || options->output == OUTPUT_NONE) return NULL;
+    trace_writer* writer = malloc(sizeof(trace_writer));
+    startTraceWriter(writer, stdout, &matchLayout, config.numPlayers, options->output == OUTPUT_BINARY, options->writerThread);
+    return writer;
 }
 
-void getRandomPos(int worldRank, pos* target) 
+// the rest of the trace is written before MPI_Finalize
+void closeOutput(trace_writer* writer)
 {
-    int field = worldRank % 12;
-    target->x = field % 4 * 32 + rand() % 32;
-    target->y = field / 4 * 32 + rand() % 32;
+    if (writer == NULL) return;
+    stopTraceWriter(writer);
+    free(writer);
 }
 
-void swapGoals(int* goalA, int* goalB)
+// collective over the ranks that report
+parallel_trace* openParallelOutput(match_options* options, MPI_Comm comm)
 {
-    *goalA = (*goalA == LEFT_GOAL) ?  RIGHT_GOAL : LEFT_GOAL;
-    *goalB = (*goalB == LEFT_GOAL) ?  RIGHT_GOAL : LEFT_GOAL;
+    if (options->tracePath == NULL) return NULL;
+    parallel_trace* parallel = malloc(sizeof(parallel_trace));
+    const char* error = openParallelTrace(parallel, comm, options->tracePath, &matchLayout);
+    if (error != NULL)
+    {
+        fprintf(stderr, "%s: %s\n", options->tracePath, error);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return parallel;
 }
 
-void incrementScore(pos ball, int goalA, int goalB, int* Ascore, int* Bscore)
+void closeParallelOutput(parallel_trace* parallel)
 {
-    int goal;
-    if (ball.x == 0) goal = LEFT_GOAL;
-    else if (ball.x == 127) goal = RIGHT_GOAL;
+    if (parallel == NULL) return;
+    closeParallelTrace(parallel);
+    free(parallel);
+}
 
-    if (goal == goalA) {
-        (*Ascore)++;
-    }
-    else if (goal == goalB) {
-        (*Bscore)++;
+// FP0 publishes every round it reports, see match_live.h
+match_live* openLiveOutput(match_options* options, int worldRank)
+{
+    if (!isFP0(worldRank) || options->liveName == NULL) return NULL;
+    match_live* live = malloc(sizeof(match_live));
+    const char* error = openLive(live, options->liveName);
+    if (error != NULL)
+    {
+        fprintf(stderr, "%s: %s\n", options->liveName, error);
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
+    return live;
 }
 
-int isFieldProcess(int worldRank)
+void closeLiveOutput(match_live* live)
 {
-    return (worldRank < 12);
+    if (live == NULL) return;
+    closeLive(live);
+    free(live);
 }
 
-int isPlayerProcess(int worldRank)
+match_summary* openSummary(match_options* options, int worldRank)
 {
-    return (worldRank >= 12 && worldRank < 34);
+    if (!isFP0(worldRank) || options->summaryPath == NULL) return NULL;
+    match_summary* summary = malloc(sizeof(match_summary));
+    initSummary(summary);
+    return summary;
 }
 
-int isTeamA(int worldRank)
+void closeSummary(match_options* options, match_summary* summary)
 {
-    return (worldRank >= 12 && worldRank < 23);
+    if (summary == NULL) return;
+    const char* error = writeSummary(summary, options->summaryPath);
+    if (error != NULL)
+    {
+        fprintf(stderr, "%s: %s\n", options->summaryPath, error);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    freeSummary(summary);
+    free(summary);
 }
 
-int isTeamB(int worldRank)
+void allocateState(match_state* state)
 {
-    return (worldRank >= 23 && worldRank < 34);
+    int slot;
+    state->members.rank = malloc(config.numPlayers * sizeof(int));
+    state->members.position = malloc(config.numPlayers * sizeof(pos));
+    state->neighbours.rank = malloc(config.numFields * sizeof(int));
+    state->neighbours.handoff = malloc(config.numFields * HANDOFF_SIZE * sizeof(int));
+    state->neighbours.arrivals = malloc(config.numFields * HANDOFF_SIZE * sizeof(int));
+    state->neighbours.leaving = malloc(config.numFields * sizeof(int));
+    state->neighbours.coming = malloc(config.numFields * sizeof(int));
+    state->neighbours.sent = malloc(config.numFields * sizeof(int));
+    state->neighbours.received = malloc(config.numFields * sizeof(int));
+    state->neighbours.displs = malloc(config.numFields * sizeof(int));
+    state->kick = malloc(config.numProcesses * sizeof(int));
+    for (slot = 0; slot < 2; slot++)
+    {
+        state->reports.packed[slot] = malloc((config.numPlayers + 1) * MAX_WIRE_SIZE);
+    }
+    state->reports.players = malloc((config.numPlayers + 1) * sizeof(football_player));
 }
 
-int isFP0(int worldRank) 
+void freeState(match_state* state)
 {
-    return worldRank == 0;
+    free(state->members.rank);
+    free(state->members.position);
+    free(state->neighbours.rank);
+    free(state->neighbours.handoff);
+    free(state->neighbours.arrivals);
+    free(state->neighbours.leaving);
+    free(state->neighbours.coming);
+    free(state->neighbours.sent);
+    free(state->neighbours.received);
+    free(state->neighbours.displs);
+    free(state->kick);
+    free(state->reports.packed[0]);
+    free(state->reports.packed[1]);
+    free(state->reports.players);
 }
 
-int isGoal(pos ball)
+void playCartRound(match_state* state)
 {
-    if (ball.x == 0 && ball.y >= 43 && ball.y <= 51) return LEFT_GOAL;
-    else if (ball.x == 127 && ball.y >= 43 && ball.y <= 51) return RIGHT_GOAL;
-    else return NO_GOAL;
+    int worldRank = state->worldRank;
+    if (isFieldProcess(worldRank))
+    {
+        int fieldWithBall = getOwner(&state->tiles, state->ball);
+        PROFILE_PHASE(PHASE_SERVE);
+        serveBall(&state->members, state->ball, state->mpi_ball);
+
+        // players that left this rank's tiles are handed to their owners
+        PROFILE_PHASE(PHASE_MOVE);
+        handOffPlayers(worldRank, &state->tiles, &state->members, &state->neighbours, state->neighbour_comm, state->mpi_ball);
+        if (state->rebalance > 0) measureLoad(&state->tiles, &state->members, state->ball);
+
+        // Field with ball will handle ball challenges
+        PROFILE_PHASE(PHASE_CHALLENGE);
+        if (worldRank == fieldWithBall)
+        {
+            handleFieldWithBall(&state->members, &state->ball, state->mpi_ball);
+        }
+
+        // field with ball broadcasts new ball position to all fields
+        PROFILE_PHASE(PHASE_BALL);
+        MPI_Bcast(&state->ball, 1, state->mpi_ball, fieldWithBall, state->field_comm);
+        updateScore(state);
+    }
+    else if (isPlayerProcess(worldRank))
+    {
+        football_player* player = &state->player;
+
+        // get ball position from field process
+        PROFILE_PHASE(PHASE_SERVE);
+        MPI_Recv(&state->ball, 1, state->mpi_ball, state->owner, TAG_BALL, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        int fieldWithBall = getFieldProcess(state->ball);
+        PROFILE_PHASE(PHASE_MOVE);
+        movePlayer(state, fieldWithBall);
+
+        // the current owner decides where the player belongs next
+        MPI_Send(&player->final, 1, state->mpi_ball, state->owner, TAG_MOVE, MPI_COMM_WORLD);
+        state->field = getFieldProcess(player->final);
+        state->owner = getOwner(&state->tiles, player->final);
+
+        PROFILE_PHASE(PHASE_CHALLENGE);
+        if (state->field == fieldWithBall && player->final.x == state->ball.x && player->final.y == state->ball.y)
+        {
+            challengeBall(worldRank, state->owner, player, state->mpi_ball, state->goalA, state->goalB);
+        }
+    }
 }
 
-int isBallWithinRange(pos ball, football_player player) 
+// Every player already knows the ball, so players move on their own and a
+// single MAXLOC reduction picks the winner. MAXLOC breaks ties towards the
+// lowest rank, which is the order the field used to check challenges in.
+// The winner stands on the ball, so everyone can replay its kick from the
+// kick attributes shared at start-up.
+void playFusedRound(match_state* state)
 {
-    int moves_left = (player.speed < 10 ? player.speed : 10);
-    
-    int diff = player.initial.x - ball.x;
-    if (player.initial.x < ball.x) diff *= -1;
-    if (diff < moves_left) moves_left -= diff;
-    else return 0;
+    int worldRank = state->worldRank;
+    football_player* player = &state->player;
+    int fieldWithBall = getFieldProcess(state->ball);
+    int challenge[2] = {0, worldRank};
+    int winner[2];
+
+    if (!isPlayerProcess(worldRank)) return;
+
+    state->field = getFieldProcess(player->initial);
+    PROFILE_PHASE(PHASE_MOVE);
+    movePlayer(state, fieldWithBall);
+    PROFILE_PHASE(PHASE_CHALLENGE);
+    if (player->final.x == state->ball.x && player->final.y == state->ball.y)
+    {
+        player->challenge = rollChallenge(&rng, player->dribbling);
+        player->reached = 1;
+        challenge[0] = player->challenge;
+    }
 
-    diff = player.initial.y - ball.y;
-    if (player.initial.y < ball.y) diff *= -1;
-    if (diff < moves_left)  moves_left -= diff;
-    else return 0;
+    MPI_Allreduce(challenge, winner, 1, MPI_2INT, MPI_MAXLOC, state->play_comm);
 
-    return (moves_left >= 0);
+    if (winner[0] > 0)
+    {
+        pos target;
+        int goal = isTeamA(winner[1]) ? state->goalA : state->goalB;
+        if (winner[1] == worldRank)
+        {
+            // Winning player kicks the ball
+            aimBall(&target, *player, goal, &rng);
+            player->kicked = 1;
+        }
+        else
+        {
+            aimAtGoal(&target, state->ball, state->kick[winner[1]], goal);
+        }
+        kickBall(target, &state->ball);
+    }
+    PROFILE_PHASE(PHASE_BALL);
+    updateScore(state);
 }
 
-void groupFieldAndPlayers(int worldRank, football_player player, int* field, MPI_Comm* subfield_comm) 
+// Players are spread in contiguous blocks over however many ranks there
+// are and each rank plays its block with the shared-memory engine, so
+// players on the same rank talk by function call. A round is one MAXLOC
+// reduction, as in the fused protocol, and a gather for the report. The
+// streams are the per-player ones, so the trace does not depend on the
+// number of ranks.
+void playHostedMatch(match_options* options, int worldRank, int worldSize)
 {
-    if (isFieldProcess(worldRank))
+    int p, half, round;
+    int firstHalf = 0, firstRound = 0;
+    int* counts = malloc(worldSize * sizeof(int));
+    int* displs = malloc(worldSize * sizeof(int));
+    int* kick = malloc(config.numPlayers * sizeof(int));
+    football_player* block = malloc(config.numPlayers * sizeof(football_player));
+    football_player* players = NULL;
+    unsigned char* wire = malloc(config.numPlayers * MAX_WIRE_SIZE);
+    unsigned char* packed = NULL;
+    int* wireCounts = malloc(worldSize * sizeof(int));
+    int* wireDispls = malloc(worldSize * sizeof(int));
+    trace_writer* writer = openOutput(options, worldRank);
+    parallel_trace* parallel = openParallelOutput(options, MPI_COMM_WORLD);
+    match_summary* summary = openSummary(options, worldRank);
+    match_live* live = openLiveOutput(options, worldRank);
+    int gather = (options->tracePath == NULL && (options->output != OUTPUT_NONE || options->liveName != NULL));
+    MPI_Datatype mpi_ball, mpi_player;
+    match_engine engine;
+    match_tally tally;
+
+    createBallStruct(&mpi_ball);
+    createPlayerStruct(mpi_ball, &mpi_player);
+    for (p = 0; p < worldSize; p++)
     {
-        *field = worldRank;
-    } 
-    else if (isPlayerProcess(worldRank)) 
+        displs[p] = (int) ((long) config.numPlayers * p / worldSize);
+        counts[p] = (int) ((long) config.numPlayers * (p + 1) / worldSize) - displs[p];
+    }
+    engineInitPlayers(&engine, options->seed, config.numFields + displs[worldRank], counts[worldRank]);
+    if (options->restart != NULL) restoreHosted(&engine, options->restart, worldRank, counts, displs, &firstHalf, &firstRound);
+    if (options->summaryPath != NULL) initTally(&tally, engine.n);
+
+    // attributes never change, so every rank learns them once
+    MPI_Allgatherv(engine.kick, engine.n, MPI_INT, kick, counts, displs, MPI_INT, MPI_COMM_WORLD);
+    if (isFP0(worldRank))
+    {
+        // FP0 comes first in the report and prints nothing for itself
+        players = malloc((config.numPlayers + 1) * sizeof(football_player));
+        memset(&players[0], 0, sizeof(football_player));
+        packed = malloc(config.numPlayers * MAX_WIRE_SIZE);
+    }
+    if (gather)
+    {
+        // FP0 learns the players whole once, then only the packed rounds, see match_wire.h
+        for (p = 0; p < engine.n; p++) engineGetPlayer(&engine, p, &block[p]);
+        MPI_Gatherv(block, engine.n, mpi_player, players + 1, counts, displs, mpi_player, 0, MPI_COMM_WORLD);
+    }
+
+    for (half = firstHalf; half < 2; half++) {
+        if (half != firstHalf || firstRound == 0) engineStartHalf(&engine);
+        for (round = (half == firstHalf ? firstRound : 0); round < config.rounds; round++) {
+            int challenge[2], winner[2];
+            int kicker = NO_WINNER;
+            pos target = engine.ball;
+
+            PROFILE_PHASE(PHASE_MOVE);
+            int local = engineMovePlayers(&engine, &challenge[0]);
+            challenge[1] = engine.first + (local == NO_WINNER ? 0 : local);
+
+            PROFILE_PHASE(PHASE_CHALLENGE);
+            MPI_Allreduce(challenge, winner, 1, MPI_2INT, MPI_MAXLOC, MPI_COMM_WORLD);
+            if (winner[0] > 0)
+            {
+                kicker = winner[1];
+                if (local != NO_WINNER && engine.first + local == kicker) engineAimBall(&engine, local, &target);
+                else aimAtGoal(&target, engine.ball, kick[kicker - config.numFields], isTeamA(kicker) ? engine.goalA : engine.goalB);
+            }
+            PROFILE_PHASE(PHASE_BALL);
+            engineEndRound(&engine, kicker, target);
+
+            PROFILE_PHASE(PHASE_REPORT);
+            if (options->summaryPath != NULL) engineTally(&engine, &tally, round);
+            for (p = 0; p < engine.n; p++) engineGetPlayer(&engine, p, &block[p]);
+            if (parallel != NULL)
+            {
+                // every rank knows the ball, FP0 hosts the first block
+                int values[MAX_TRACE_FIELDS];
+                if (isFP0(worldRank)) addTraceHeader(parallel, round, engine.ball.x, engine.ball.y);
+                for (p = 0; p < engine.n; p++)
+                {
+                    getPlayerLine(block[p], values);
+                    addTraceLines(parallel, values, 1);
+                }
+                endTraceRound(parallel);
+            }
+            else if (gather)
+            {
+                int size = wireSize(round == 0);
+                for (p = 0; p < engine.n; p++) packPlayer(&block[p], round == 0, wire + p * size);
+                for (p = 0; p < worldSize; p++)
+                {
+                    wireCounts[p] = counts[p] * size;
+                    wireDispls[p] = displs[p] * size;
+                }
+                MPI_Gatherv(wire, engine.n * size, MPI_BYTE, packed, wireCounts, wireDispls, MPI_BYTE, 0, MPI_COMM_WORLD);
+                if (isFP0(worldRank))
+                {
+                    for (p = 0; p < config.numPlayers; p++) unpackPlayer(packed + p * size, round == 0, &players[p + 1]);
+                }
+            }
+            if (live != NULL) publishLive(live, half, round, engine.ball, engine.Ascore, engine.Bscore, players + 1);
+            if (writer != NULL)
+            {
+                PROFILE_PHASE(PHASE_PRINT);
+                trace_slot* snapshot = nextTraceSlot(writer);
+                snapshot->round = round;
+                snapshot->ballX = engine.ball.x;
+                snapshot->ballY = engine.ball.y;
+                getPlayerLines(players, snapshot->values);
+                commitTraceSlot(writer);
+            }
+            if (options->every > 0 && (round + 1) % options->every == 0 && round + 1 < config.rounds)
+            {
+                saveHosted(&engine, options, writer, parallel, worldRank, counts, displs, half, round + 1);
+            }
+        }
+        if (options->summaryPath != NULL) combineHalf(MPI_COMM_WORLD, &tally, summary, half, engine.Ascore, engine.Bscore);
+        if (options->every > 0 && half == 0) saveHosted(&engine, options, writer, parallel, worldRank, counts, displs, 1, 0);
+        if (DEBUG) if (isFP0(worldRank)) printf("Half-time score: A %d:%d B\n", engine.Ascore, engine.Bscore);
+    }
+    if (DEBUG) if (isFP0(worldRank)) printf("Final score: A %d:%d B\n", engine.Ascore, engine.Bscore);
+
+    if (options->summaryPath != NULL)
     {
-        
-        *field = getFieldProcess(player.final);
+        combinePlayers(MPI_COMM_WORLD, &tally, summary);
+        closeSummary(options, summary);
+        freeTally(&tally);
     }
-    MPI_Comm_split(MPI_COMM_WORLD, *field, worldRank, subfield_comm);
+    engineFree(&engine);
+    closeOutput(writer);
+    closeParallelOutput(parallel);
+    closeLiveOutput(live);
+    free(players);
+    free(packed);
+    free(wire);
+    free(wireCounts);
+    free(wireDispls);
+    free(block);
+    free(kick);
+    free(counts);
+    free(displs);
 }
 
 void groupAllFieldProcesses(int worldRank, MPI_Comm* field_comm)
@@ -348,185 +802,600 @@ void groupFP0AndPlayers(int worldRank, MPI_Comm* reporting_comm)
     MPI_Comm_split(MPI_COMM_WORLD, colour, worldRank, reporting_comm);
 }
 
-int getFieldProcess(pos player) 
+void groupPlayers(int worldRank, MPI_Comm* play_comm)
+{
+    int colour = isPlayerProcess(worldRank) ? 0 : MPI_UNDEFINED;
+    MPI_Comm_split(MPI_COMM_WORLD, colour, worldRank, play_comm);
+}
+
+// With the default tiles and cells of at least 10 x 10 these are the up
+// to 8 cells around a rank's own, as a player cannot cross a whole cell
+void createFieldTopology(int worldRank, MPI_Comm field_comm, field_tiles* tiles, MPI_Comm* neighbour_comm, field_neighbours* neighbours)
 {
-    if (player.y >= 0 && player.y <= 31)
+    int a, b, rank;
+    int* near = calloc(config.numFields, sizeof(int));
+
+    for (a = 0; a < tiles->count; a++)
     {
-        if (player.x >= 0 && player.x <= 31) return 0;
-        if (player.x >= 32 && player.x <= 63) return 1;
-        if (player.x >= 64 && player.x <= 95) return 2;
-        if (player.x >= 95 && player.x <= 127) return 3;
+        if (tiles->owner[a] != worldRank) continue;
+        for (b = 0; b < tiles->count; b++)
+        {
+            if (tiles->owner[b] != worldRank && isTileInReach(tiles, a, b)) near[tiles->owner[b]] = TRUE;
+        }
     }
-    else if (player.y >= 32 && player.y <= 63)
+
+    neighbours->count = 0;
+    for (rank = 0; rank < config.numFields; rank++)
     {
-        if (player.x >= 0 && player.x <= 31) return 4;
-        if (player.x >= 32 && player.x <= 63) return 5;
-        if (player.x >= 64 && player.x <= 95) return 6;
-        if (player.x >= 95 && player.x <= 127) return 7;
+        if (near[rank]) neighbours->rank[neighbours->count++] = rank;
     }
-    else if (player.y >= 64 && player.y <= 95)
+
+    free(near);
+
+    // every edge weighs the same, given as weights rather than MPI_UNWEIGHTED,
+    // a sentinel compilers take for an array too small to read
+    int* weights = malloc(config.numFields * sizeof(int));
+    for (rank = 0; rank < config.numFields; rank++) weights[rank] = 1;
+
+    // reach is symmetric, so every rank lists the ranks that list it
+    MPI_Dist_graph_create_adjacent(field_comm, neighbours->count, neighbours->rank, weights,
+        neighbours->count, neighbours->rank, weights, MPI_INFO_NULL, 0, neighbour_comm);
+    free(weights);
+}
+
+void assignMembers(int worldRank, football_player player, MPI_Datatype mpi_ball, field_tiles* tiles, field_members* members)
+{
+    int p;
+    pos* positions = malloc(config.numProcesses * sizeof(pos));
+    MPI_Allgather(&player.final, 1, mpi_ball, positions, 1, mpi_ball, MPI_COMM_WORLD);
+
+    members->count = 0;
+    for (p = config.numFields; p < config.numProcesses && isFieldProcess(worldRank); p++)
     {
-        if (player.x >= 0 && player.x <= 31) return 8;
-        if (player.x >= 32 && player.x <= 63) return 9;
-        if (player.x >= 64 && player.x <= 95) return 10;
-        if (player.x >= 95 && player.x <= 127) return 11;
+        if (getOwner(tiles, positions[p]) == worldRank) addMember(members, p, positions[p]);
     }
-    printf("Error: invalid player %d %d\n", player.x, player.y);
-    return -1;
+    free(positions);
 }
 
-void tryToReach(pos target, football_player* player)
+void addMember(field_members* members, int rank, pos position)
 {
-    player->final.x = player->initial.x;
-    player->final.y = player->initial.y;
-    int moves_left = (player->speed < 10 ? player->speed : 10);
+    members->rank[members->count] = rank;
+    members->position[members->count] = position;
+    members->count++;
+}
 
-    int diff = player->initial.x - target.x;
-    if (player->initial.x > target.x) 
+void serveBall(field_members* members, pos ball, MPI_Datatype mpi_ball)
+{
+    int m;
+    for (m = 0; m < members->count; m++)
     {
-        int move = (diff < moves_left ? diff : moves_left);
-        player->final.x = player->initial.x - move;
+        MPI_Send(&ball, 1, mpi_ball, members->rank[m], TAG_BALL, MPI_COMM_WORLD);
     }
-    diff = target.x - player->initial.x;
-    if (player->initial.x < target.x) 
+}
+
+void handOffPlayers(int worldRank, field_tiles* tiles, field_members* members, field_neighbours* neighbours, MPI_Comm neighbour_comm, MPI_Datatype mpi_ball)
+{
+    int m, n, i;
+    int size = HANDOFF_SIZE;
+    int* handoff = neighbours->handoff;
+    int* arrivals = neighbours->arrivals;
+    int* leaving = neighbours->leaving;
+    int stayed = 0;
+
+    for (n = 0; n < neighbours->count; n++) leaving[n] = 0;
+
+    for (m = 0; m < members->count; m++)
     {
-        int move = (diff < moves_left ? diff : moves_left);
-        player->final.x = player->initial.x + move;
+        pos position;
+        MPI_Recv(&position, 1, mpi_ball, members->rank[m], TAG_MOVE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        int next = getOwner(tiles, position);
+        if (next == worldRank)
+        {
+            members->rank[stayed] = members->rank[m];
+            members->position[stayed] = position;
+            stayed++;
+            continue;
+        }
+
+        for (n = 0; n < neighbours->count; n++)
+        {
+            if (neighbours->rank[n] == next) break;
+        }
+        if (n == neighbours->count)
+        {
+            printf("Error: player %d left field %d for field %d out of reach\n", members->rank[m], worldRank, next);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        int* entry = &handoff[n * size + 3 * leaving[n]];
+        entry[0] = members->rank[m];
+        entry[1] = position.x;
+        entry[2] = position.y;
+        leaving[n]++;
     }
+    members->count = stayed;
 
-    diff = player->initial.y - target.y;
-    if (player->initial.y > target.y) 
+    // hardly anyone crosses a tile edge in a round, so neighbours swap
+    // counts first and only the players who do cross follow
+    MPI_Neighbor_alltoall(leaving, 1, MPI_INT, neighbours->coming, 1, MPI_INT, neighbour_comm);
+    for (n = 0; n < neighbours->count; n++)
     {
-        int move = (diff < moves_left ? diff : moves_left);
-        player->final.y = player->initial.y - move;
+        neighbours->sent[n] = 3 * leaving[n];
+        neighbours->received[n] = 3 * neighbours->coming[n];
+        neighbours->displs[n] = n * size;
     }
-    diff = target.y - player->initial.y;
-    if (player->initial.y < target.y) 
+    MPI_Neighbor_alltoallv(handoff, neighbours->sent, neighbours->displs, MPI_INT,
+        arrivals, neighbours->received, neighbours->displs, MPI_INT, neighbour_comm);
+    for (n = 0; n < neighbours->count; n++)
+    {
+        for (i = 0; i < neighbours->coming[n]; i++)
+        {
+            int* entry = &arrivals[n * size + 3 * i];
+            pos position = {entry[1], entry[2]};
+            addMember(members, entry[0], position);
+        }
+    }
+}
+
+// Serving a player costs two messages a round and a challenge two more,
+// so a tile's load is its players plus those challenging for the ball
+void measureLoad(field_tiles* tiles, field_members* members, pos ball)
+{
+    int m;
+    for (m = 0; m < members->count; m++)
     {
-        int move = (diff < moves_left ? diff : moves_left);
-        player->final.y = player->initial.y + move;
+        pos position = members->position[m];
+        tiles->load[getTile(tiles, position)] += 1 + (position.x == ball.x && position.y == ball.y);
     }
 }
 
-void aimBall(pos* target, football_player player, int goal)
+// Field ranks add up the load seen on their tiles and FP0 cuts the field
+// again. Everyone learns the owners; the ball is already known everywhere
+// and the members are rebuilt from the players' positions, so nothing
+// else has to move. Players are where they were, so the trace does not change.
+void rebalanceField(match_state* state)
 {
-    int moves_left = player.kick * 2;
-    target->x = player.final.x;
-    target->y = player.final.y;
-    int direction = rand() % 2;
-    if (goal == LEFT_GOAL) {
-        // move in x first
-        if (player.final.x != 0) {
-            int diff = player.final.x;
-            int move = (diff < moves_left ? diff : moves_left);
-            moves_left -= move;
-            target->x = player.final.x - move;
+    field_tiles* tiles = &state->tiles;
+    int worldRank = state->worldRank;
+    int* owner = malloc(tiles->count * sizeof(int));
+    long* load = NULL;
+
+    memcpy(owner, tiles->owner, tiles->count * sizeof(int));
+    if (isFieldProcess(worldRank))
+    {
+        if (isFP0(worldRank)) load = malloc(tiles->count * sizeof(long));
+        MPI_Reduce(tiles->load, load, tiles->count, MPI_LONG, MPI_SUM, 0, state->field_comm);
+        memset(tiles->load, 0, tiles->count * sizeof(long));
+    }
+    if (isFP0(worldRank))
+    {
+        int* cut = malloc(tiles->count * sizeof(int));
+        balanceTiles(tiles, load, cut);
+        if (heaviestOwner(tiles, load, cut) * 100 < heaviestOwner(tiles, load, tiles->owner) * REBALANCE_KEEP)
+        {
+            memcpy(owner, cut, tiles->count * sizeof(int));
         }
-        if (player.final.y < 43)
+        free(cut);
+        free(load);
+    }
+    MPI_Bcast(owner, tiles->count, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (memcmp(owner, tiles->owner, tiles->count * sizeof(int)) != 0)
+    {
+        memcpy(tiles->owner, owner, tiles->count * sizeof(int));
+        assignMembers(worldRank, state->player, state->mpi_ball, tiles, &state->members);
+        if (isFieldProcess(worldRank))
         {
-            int diff = 43 - player.final.y;
-            int move = (diff < moves_left ? diff : moves_left);
-            moves_left -= move;
-            target->y = player.final.y + move;
+            MPI_Comm_free(&state->neighbour_comm);
+            createFieldTopology(worldRank, state->field_comm, tiles, &state->neighbour_comm, &state->neighbours);
         }
-        if (player.final.y > 51)
+        state->owner = getOwner(tiles, state->player.final);
+    }
+    free(owner);
+}
+
+void movePlayer(match_state* state, int fieldWithBall)
+{
+    football_player* player = &state->player;
+    if (state->field == fieldWithBall)
+    {
+        // run after ball
+        tryToReach(state->ball, player);
+    }
+    else if (isBallWithinRange(state->ball, *player))
+    {
+        // check if ball is within range
+        moveTo(state->ball, player);
+    }
+    else {
+        // move to default position
+        pos target;
+        getRandomPos(state->worldRank, &rng, &target);
+        tryToReach(target, player);
+    }
+}
+
+void updateScore(match_state* state)
+{
+    if (isGoal(state->ball))
+    {
+        // increment score
+        incrementScore(state->ball, state->goalA, state->goalB, &state->Ascore, &state->Bscore);
+        resetBall(&state->ball);
+    }
+}
+
+// FP0 sits out the fused protocol, so it replays the kick from the report
+void followBall(match_state* state, football_player players[])
+{
+    int p;
+    for (p = 0; p <= config.numPlayers; p++)
+    {
+        if (isPlayerProcess(players[p].id) && players[p].kicked)
         {
-            int diff = player.final.y - 51;
-            int move = (diff < moves_left ? diff : moves_left);
-            moves_left -= move;
-            target->y = player.final.y - move;
+            pos target;
+            int goal = isTeamA(players[p].id) ? state->goalA : state->goalB;
+            aimAtGoal(&target, players[p].final, state->kick[players[p].id], goal);
+            kickBall(target, &state->ball);
         }
-    } 
-    else 
-    {
-        // move in x first
-        if (player.final.x != 127) {
-            int diff = 127 - player.final.x;
-            int move = (diff < moves_left ? diff : moves_left);
-            moves_left -= move;
-            target->x = player.final.x + move;
+    }
+    updateScore(state);
+}
+
+// FP0 holds the ball and score in both protocols, the players hold
+// themselves and their streams. Field cells are rebuilt from the players'
+// positions on restart, so the other field ranks have nothing to save.
+void saveMatch(match_state* state, match_options* options, int half, int round, int tick)
+{
+    player_checkpoint mine;
+    player_checkpoint* players = NULL;
+
+    if (!isFP0(state->worldRank) && !isPlayerProcess(state->worldRank)) return;
+
+    // the reports have to be printed up to the checkpoint
+    int previous = PROFILE_NESTED(PHASE_CHECKPOINT);
+    flushReports(state);
+    mine.player = state->player;
+    mine.rng = rng;
+    if (isFP0(state->worldRank)) players = malloc((config.numPlayers + 1) * sizeof(player_checkpoint));
+    MPI_Gather(&mine, sizeof(mine), MPI_BYTE, players, sizeof(mine), MPI_BYTE, 0, state->reporting_comm);
+    if (state->reports.parallel != NULL) flushParallelTrace(state->reports.parallel);
+    if (!state->reports.gather && state->protocol == PROTOCOL_FUSED)
+    {
+        // FP0 follows the ball through the reports, which it did not get
+        int ball[4] = {state->ball.x, state->ball.y, state->Ascore, state->Bscore};
+        MPI_Bcast(ball, 4, MPI_INT, 1, state->reporting_comm);
+        state->ball.x = ball[0];
+        state->ball.y = ball[1];
+        state->Ascore = ball[2];
+        state->Bscore = ball[3];
+    }
+
+    if (isFP0(state->worldRank))
+    {
+        match_checkpoint header;
+        initCheckpoint(&header, options->seed, half, round, tick);
+        header.ball = state->ball;
+        header.goalA = state->goalA;
+        header.goalB = state->goalB;
+        header.Ascore = state->Ascore;
+        header.Bscore = state->Bscore;
+
+        // FP0 comes first in the reporting comm
+        const char* error = saveCheckpoint(options->checkpoint, &header, players + 1);
+        if (error != NULL)
+        {
+            fprintf(stderr, "%s: %s\n", options->checkpoint, error);
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
-        if (player.final.y < 43)
+        if (state->reports.writer != NULL) syncTraceWriter(state->reports.writer);
+        free(players);
+    }
+    PROFILE_PHASE(previous);
+}
+
+void restoreMatch(match_state* state, char* path, int* half, int* round, int* tick)
+{
+    match_checkpoint header;
+    player_checkpoint mine;
+    player_checkpoint* players = NULL;
+
+    if (isFP0(state->worldRank))
+    {
+        player_checkpoint* loaded;
+        const char* error = loadCheckpoint(path, &header, &loaded);
+        if (error != NULL)
         {
-            int diff = 43 - player.final.y;
-            int move = (diff < moves_left ? diff : moves_left);
-            moves_left -= move;
-            target->y = player.final.y + move;
+            fprintf(stderr, "%s: %s\n", path, error);
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
-        if (player.final.y > 51)
+        players = malloc((config.numPlayers + 1) * sizeof(player_checkpoint));
+        memcpy(players + 1, loaded, config.numPlayers * sizeof(player_checkpoint));
+        free(loaded);
+    }
+    MPI_Bcast(&header, sizeof(header), MPI_BYTE, 0, MPI_COMM_WORLD);
+    if (isFP0(state->worldRank) || isPlayerProcess(state->worldRank))
+    {
+        MPI_Scatter(players, sizeof(mine), MPI_BYTE, &mine, sizeof(mine), MPI_BYTE, 0, state->reporting_comm);
+    }
+    if (isPlayerProcess(state->worldRank))
+    {
+        state->player = mine.player;
+        rng = mine.rng;
+    }
+    free(players);
+
+    *half = header.half;
+    *round = header.round;
+    *tick = header.tick;
+    state->ball = header.ball;
+    state->goalA = header.goalA;
+    state->goalB = header.goalB;
+    state->Ascore = header.Ascore;
+    state->Bscore = header.Bscore;
+}
+
+// Every rank holds the whole header, FP0 collects the players' blocks
+void saveHosted(match_engine* engine, match_options* options, trace_writer* writer, parallel_trace* parallel, int worldRank, int counts[], int displs[], int half, int round)
+{
+    match_checkpoint header;
+    player_checkpoint* mine = malloc(engine->n * sizeof(player_checkpoint));
+    player_checkpoint* players = NULL;
+    MPI_Datatype mpi_entry;
+
+    int previous = PROFILE_NESTED(PHASE_CHECKPOINT);
+    MPI_Type_contiguous(sizeof(player_checkpoint), MPI_BYTE, &mpi_entry);
+    MPI_Type_commit(&mpi_entry);
+    engineCheckpoint(engine, &header, mine, options->seed, half, round);
+    if (isFP0(worldRank)) players = malloc(config.numPlayers * sizeof(player_checkpoint));
+    MPI_Gatherv(mine, engine->n, mpi_entry, players, counts, displs, mpi_entry, 0, MPI_COMM_WORLD);
+    if (parallel != NULL) flushParallelTrace(parallel);
+
+    if (isFP0(worldRank))
+    {
+        const char* error = saveCheckpoint(options->checkpoint, &header, players);
+        if (error != NULL)
         {
-            int diff = player.final.y - 51;
-            int move = (diff < moves_left ? diff : moves_left);
-            moves_left -= move;
-            target->y = player.final.y - move;
+            fprintf(stderr, "%s: %s\n", options->checkpoint, error);
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
+        if (writer != NULL) syncTraceWriter(writer);
     }
-    // printf("target %d %d\n", target->x, target->y);
+    MPI_Type_free(&mpi_entry);
+    free(players);
+    free(mine);
+    PROFILE_PHASE(previous);
 }
 
-void kickBall(pos target, pos* ball) 
+void restoreHosted(match_engine* engine, char* path, int worldRank, int counts[], int displs[], int* half, int* round)
 {
-    ball->x = target.x;
-    ball->y = target.y;
+    match_checkpoint header;
+    player_checkpoint* mine = malloc(engine->n * sizeof(player_checkpoint));
+    player_checkpoint* players = NULL;
+    MPI_Datatype mpi_entry;
+
+    if (isFP0(worldRank))
+    {
+        const char* error = loadCheckpoint(path, &header, &players);
+        if (error != NULL)
+        {
+            fprintf(stderr, "%s: %s\n", path, error);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    MPI_Type_contiguous(sizeof(player_checkpoint), MPI_BYTE, &mpi_entry);
+    MPI_Type_commit(&mpi_entry);
+    MPI_Bcast(&header, sizeof(header), MPI_BYTE, 0, MPI_COMM_WORLD);
+    MPI_Scatterv(players, counts, displs, mpi_entry, mine, engine->n, mpi_entry, 0, MPI_COMM_WORLD);
+    engineRestore(engine, &header, mine);
+    *half = header.half;
+    *round = header.round;
+
+    MPI_Type_free(&mpi_entry);
+    free(players);
+    free(mine);
 }
 
-void moveTo(pos target, football_player* player)
+void printFieldMembers(int worldRank, field_members* members)
 {
-    player->final.x = target.x;
-    player->final.y = target.y;
+    int m;
+    printf("FIELD %d:", worldRank);
+    for (m = 0; m < members->count; m++)
+    {
+        printf(" %d(%d,%d)", members->rank[m], members->position[m].x, members->position[m].y);
+    }
+    printf("\n");
 }
 
-void printPlayerInfo(football_player player[23]) 
+// FP0 learns every player whole, attributes included, before the first
+// round it gets reports of. Rounds are completed in order, so from then
+// on each report updates what FP0 already knows.
+void startReports(match_state* state)
 {
-    int p;
-    for (p = 0; p < 23; p++)
+    if (!isFP0(state->worldRank) && !isPlayerProcess(state->worldRank)) return;
+    if (!state->reports.gather) return;
+    MPI_Gather(&state->player, 1, state->mpi_player, state->reports.players, 1, state->mpi_player, 0, state->reporting_comm);
+}
+
+void reportRound(match_state* state, int half, int round)
+{
+    match_reports* reports = &state->reports;
+    int slot = reports->next;
+
+    // all players send their position to field 0
+    if (!isFP0(state->worldRank) && !isPlayerProcess(state->worldRank)) return;
+    if (reports->parallel != NULL)
+    {
+        reportPart(state, round);
+        return;
+    }
+    if (!reports->gather) return;
+
+    // the first round of a half also carries where the kick-off put everyone
+    int size = wireSize(round == 0);
+    packPlayer(&state->player, round == 0, reports->sent[slot]);
+    reports->half[slot] = half;
+    reports->round[slot] = round;
+    reports->ball[slot] = state->ball;
+    reports->score[slot][0] = state->Ascore;
+    reports->score[slot][1] = state->Bscore;
+    reports->pending[slot] = TRUE;
+    if (reports->mode == REPORT_SYNC)
+    {
+        MPI_Gather(reports->sent[slot], size, MPI_BYTE, reports->packed[slot], size, MPI_BYTE, 0, state->reporting_comm);
+        completeReport(state, slot);
+        return;
+    }
+
+    MPI_Igather(reports->sent[slot], size, MPI_BYTE, reports->packed[slot], size, MPI_BYTE, 0, state->reporting_comm, &reports->request[slot]);
+    reports->next = 1 - slot;
+
+    // the previous round has had a whole round to arrive
+    if (reports->pending[reports->next]) completeReport(state, reports->next);
+}
+
+// With -w each reporting rank writes its own line. FP0 knows the ball in
+// the cart protocol and the players do in the fused one, so the first
+// player adds the header there, right before its own line.
+void reportPart(match_state* state, int round)
+{
+    int values[MAX_TRACE_FIELDS];
+    int headerRank = (state->protocol == PROTOCOL_CART) ? 0 : config.numFields;
+    if (state->worldRank == headerRank) addTraceHeader(state->reports.parallel, round, state->ball.x, state->ball.y);
+    if (isPlayerProcess(state->worldRank))
     {
-        if (player[p].id > 11 && player[p].id < 23)
+        getPlayerLine(state->player, values);
+        addTraceLines(state->reports.parallel, values, 1);
+    }
+    endTraceRound(state->reports.parallel);
+}
+
+void completeReport(match_state* state, int slot)
+{
+    match_reports* reports = &state->reports;
+    if (reports->mode == REPORT_ASYNC) MPI_Wait(&reports->request[slot], MPI_STATUS_IGNORE);
+    reports->pending[slot] = FALSE;
+
+    if (isFP0(state->worldRank))
+    {
+        int p, kickOff = (reports->round[slot] == 0);
+        int size = wireSize(kickOff);
+        for (p = 0; p <= config.numPlayers; p++)
+        {
+            unpackPlayer(reports->packed[slot] + p * size, kickOff, &reports->players[p]);
+        }
+        if (state->protocol == PROTOCOL_FUSED)
         {
-            printf("%d ", player[p].id - 12);
+            followBall(state, reports->players);
+            reports->ball[slot] = state->ball;
+            reports->score[slot][0] = state->Ascore;
+            reports->score[slot][1] = state->Bscore;
         }
-        if (player[p].id > 22 && player[p].id < 34)
+        // the writer formats and prints the round while the next is played
+        int previous = PROFILE_NESTED(PHASE_PRINT);
+        if (reports->live != NULL)
         {
-            printf("%d ", player[p].id - 23);
+            publishLive(reports->live, reports->half[slot], reports->round[slot], reports->ball[slot],
+                reports->score[slot][0], reports->score[slot][1], reports->players + 1);
         }
-        if (player[p].id > 11) 
+        if (reports->writer != NULL)
         {
-            printf("%d %d ", player[p].initial.x, player[p].initial.y);
-            printf("%d %d ", player[p].final.x, player[p].final.y);
-            printf("%d ", player[p].reached);
-            printf("%d ", player[p].kicked);
-            printf("%d ", player[p].challenge);
-            printf("\n");
+            trace_slot* snapshot = nextTraceSlot(reports->writer);
+            snapshot->round = reports->round[slot];
+            snapshot->ballX = reports->ball[slot].x;
+            snapshot->ballY = reports->ball[slot].y;
+            getPlayerLines(reports->players, snapshot->values);
+            commitTraceSlot(reports->writer);
         }
+        PROFILE_PHASE(previous);
     }
 }
 
-void printFieldGroups(int worldRank, int worldSize, MPI_Comm subfield_comm)
+void flushReports(match_state* state)
 {
-    int fieldRank, fieldSize;
-    MPI_Comm_rank(subfield_comm, &fieldRank);
-    MPI_Comm_size(subfield_comm, &fieldSize);
-    printf("WORLD RANK/SIZE: %d/%d \t ROW RANK/SIZE: %d/%d\n", worldRank, worldSize, fieldRank, fieldSize);
+    match_reports* reports = &state->reports;
+    if (!isFP0(state->worldRank) && !isPlayerProcess(state->worldRank)) return;
+    if (reports->pending[reports->next]) completeReport(state, reports->next);
+    if (reports->pending[1 - reports->next]) completeReport(state, 1 - reports->next);
 }
 
-void startHalf(int worldRank, football_player* player) 
+// Rank 0 of comm puts the half together. Only some ranks follow the
+// score, the others hold 0 or where they last knew it, and the score only
+// goes up, so the highest is the right one.
+void combineHalf(MPI_Comm comm, match_tally* tally, match_summary* summary, int half, int Ascore, int Bscore)
 {
-    pos target;
-    getRandomPos(worldRank, &target);
-    player->final.x = target.x;
-    player->final.y = target.y;
-    player->initial.x = player->final.x;
-    player->initial.y = player->final.y;
-    
+    int r, rank, size, total = 0;
+    int score[2] = {Ascore, Bscore}, highest[2];
+    int* counts = NULL;
+    int* displs = NULL;
+    int* kicks = NULL;
+
+    int previous = PROFILE_NESTED(PHASE_STATS);
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    MPI_Reduce(score, highest, 2, MPI_INT, MPI_MAX, 0, comm);
+    if (rank == 0)
+    {
+        counts = malloc(size * sizeof(int));
+        displs = malloc(size * sizeof(int));
+    }
+    MPI_Gather(&tally->numKicks, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+    if (rank == 0)
+    {
+        for (r = 0; r < size; r++)
+        {
+            displs[r] = total;
+            total += counts[r];
+        }
+        kicks = malloc((total + 1) * sizeof(int));
+    }
+    MPI_Gatherv(tally->kicks, tally->numKicks, MPI_INT, kicks, counts, displs, MPI_INT, 0, comm);
+    if (rank == 0) addHalf(summary, half, highest[0], highest[1], kicks, total);
+    tally->numKicks = 0;
+
+    free(kicks);
+    free(counts);
+    free(displs);
+    PROFILE_PHASE(previous);
 }
 
-void startRound(football_player* player)
+// Ranks hold their players in trace order, so their tallies go one after
+// the other into rank 0's summary
+void combinePlayers(MPI_Comm comm, match_tally* tally, match_summary* summary)
 {
-    player->initial.x = player->final.x;
-    player->initial.y = player->final.y;
-    player->kicked = 0;
-    player->reached = 0;
-    player->challenge = -1;
+    int r, rank, size, total = 0;
+    int* counts = NULL;
+    int* displs = NULL;
+    MPI_Datatype mpi_values, mpi_heat;
+
+    int previous = PROFILE_NESTED(PHASE_STATS);
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    if (rank == 0)
+    {
+        counts = malloc(size * sizeof(int));
+        displs = malloc(size * sizeof(int));
+    }
+    MPI_Gather(&tally->count, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+    if (rank == 0)
+    {
+        for (r = 0; r < size; r++)
+        {
+            displs[r] = total;
+            total += counts[r];
+        }
+    }
+    MPI_Type_contiguous(TALLY_VALUES, MPI_INT, &mpi_values);
+    MPI_Type_commit(&mpi_values);
+    MPI_Type_contiguous(tally->cells, MPI_INT, &mpi_heat);
+    MPI_Type_commit(&mpi_heat);
+    MPI_Gatherv(tally->values, tally->count, mpi_values, rank == 0 ? summary->players.values : NULL, counts, displs, mpi_values, 0, comm);
+    MPI_Gatherv(tally->heat, tally->count, mpi_heat, rank == 0 ? summary->players.heat : NULL, counts, displs, mpi_heat, 0, comm);
+
+    MPI_Type_free(&mpi_values);
+    MPI_Type_free(&mpi_heat);
+    free(counts);
+    free(displs);
+    PROFILE_PHASE(previous);
 }
 
 void createBallStruct(MPI_Datatype* mpi_ball) 
@@ -564,63 +1433,54 @@ void createPlayerStruct(MPI_Datatype mpi_ball, MPI_Datatype* mpi_player)
     MPI_Type_commit(mpi_player);
 }
 
-void handleFieldWithBall(int worldRank, football_player* player, pos* ball, MPI_Comm subfield_comm, MPI_Datatype mpi_ball, int goalA, int goalB) 
+void challengeBall(int worldRank, int field, football_player* player, MPI_Datatype mpi_ball, int goalA, int goalB)
 {
-    
-    int fieldSize, fieldRank;
-    MPI_Comm_rank(subfield_comm, &fieldRank);
-    MPI_Comm_size(subfield_comm, &fieldSize);
+    int won;
+    player->challenge = rollChallenge(&rng, player->dribbling);
+    player->reached = 1;
+    MPI_Send(&player->challenge, 1, MPI_INT, field, TAG_CHALLENGE, MPI_COMM_WORLD);
+    MPI_Recv(&won, 1, MPI_INT, field, TAG_WINNER, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
-    int challenge[2], winner;
-    challenge[0] = 0;
-    challenge[1] = fieldRank;
-    if (isPlayerProcess(worldRank) && player->final.x == ball->x && player->final.y == ball->y) 
+    if (won)
     {
-        challenge[0] = (rand() % 9) + 1;
-        challenge[0] *= player->dribbling;
-        player->challenge = challenge[0];
-        player->reached = 1;
+        // Winning player kicks the ball
+        pos target, ball;
+        if (isTeamA(worldRank)) aimBall(&target, *player, goalA, &rng);
+        else if (isTeamB(worldRank)) aimBall(&target, *player, goalB, &rng);
+        kickBall(target, &ball);
+        player->kicked = 1;
+        MPI_Send(&ball, 1, mpi_ball, field, TAG_BALL, MPI_COMM_WORLD);
     }
-    
-    int challenges[44];
-    MPI_Gather(&challenge, 2, MPI_INT, &challenges, 2, MPI_INT, 0, subfield_comm);
+}
 
-    if (isFieldProcess(worldRank))
+void handleFieldWithBall(field_members* members, pos* ball, MPI_Datatype mpi_ball)
+{
+    int m, challenge, topChallenge;
+    int winner = NO_WINNER;
+    topChallenge = 0;
+
+    // only players standing on the ball challenge for it
+    for (m = 0; m < members->count; m++)
     {
-        int p, topChallenge;
-        topChallenge = 0;
-        winner = NO_WINNER;
-        for (p = 0; p < 2*fieldSize; p+=2)
+        if (members->position[m].x != ball->x || members->position[m].y != ball->y) continue;
+        MPI_Recv(&challenge, 1, MPI_INT, members->rank[m], TAG_CHALLENGE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        // ties go to the lowest rank, as they did when ranked within the subfield
+        if (challenge > topChallenge || (challenge == topChallenge && members->rank[m] < winner))
         {
-            // printf("(%d,%d) ", challenges[p+1], challenges[p]);
-            if (challenges[p+1] != 0 && challenges[p] > topChallenge)
-            {
-                topChallenge = challenges[p];
-                winner = challenges[p+1];
-            }
+            topChallenge = challenge;
+            winner = members->rank[m];
         }
-        // printf("\n");
     }
-    
-    // broadcast winner to all participants
-    MPI_Bcast(&winner, 1, MPI_INT, 0, subfield_comm);
-    
-    if (winner != NO_WINNER)
-    {
-        // Winning player kicks the ball
-        if (fieldRank == winner) {
-            // printf("winner: %d\n", worldRank);
 
-            pos target;
-            if (isTeamA(worldRank)) aimBall(&target, *player, goalA);
-            else if (isTeamB(worldRank)) aimBall(&target, *player, goalB);
-            kickBall(target, ball);
-            player->kicked = 1;
-            // printf("kicked to %d %d\n", ball->x, ball->y);
-
-        }
-        // broadcast new ball position to field
-        MPI_Bcast(ball, 1, mpi_ball, winner, subfield_comm);
+    for (m = 0; m < members->count; m++)
+    {
+        if (members->position[m].x != ball->x || members->position[m].y != ball->y) continue;
+        int won = (members->rank[m] == winner);
+        MPI_Send(&won, 1, MPI_INT, members->rank[m], TAG_WINNER, MPI_COMM_WORLD);
+    }
 
+    if (winner != NO_WINNER)
+    {
+        MPI_Recv(ball, 1, mpi_ball, winner, TAG_BALL, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
     }
-}
+}
\ No newline at end of file
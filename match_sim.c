@@ -0,0 +1,79 @@
+#include "match_sim.h"
+
+void simInit(match_sim* sim, int seed)
+{
+    engineInit(&sim->engine, seed);
+    sim->seed = seed;
+    sim->half = 0;
+    sim->round = 0;
+}
+
+const char* simLoad(match_sim* sim, char* path)
+{
+    return engineLoad(&sim->engine, path, &sim->half, &sim->round);
+}
+
+const char* simSave(match_sim* sim, char* path)
+{
+    return engineSave(&sim->engine, path, sim->seed, sim->half, sim->round);
+}
+
+void simFree(match_sim* sim)
+{
+    engineFree(&sim->engine);
+}
+
+int simFinished(match_sim* sim)
+{
+    return sim->half >= 2;
+}
+
+void simStep(match_sim* sim)
+{
+    if (simFinished(sim)) return;
+    if (sim->round == 0) engineStartHalf(&sim->engine);
+    enginePlayRound(&sim->engine);
+    if (++sim->round == config.rounds)
+    {
+        sim->half++;
+        sim->round = 0;
+    }
+}
+
+int simRun(match_sim* sim, int rounds)
+{
+    int played = 0;
+    while (played < rounds && !simFinished(sim))
+    {
+        simStep(sim);
+        played++;
+    }
+    return played;
+}
+
+void simSnapshot(match_sim* sim, match_snapshot* snapshot)
+{
+    match_engine* engine = &sim->engine;
+    snapshot->half = sim->half;
+    snapshot->round = sim->round - 1;
+    if (sim->round == 0)
+    {
+        // the last round of the half before
+        snapshot->half = sim->half - 1;
+        snapshot->round = config.rounds - 1;
+    }
+    snapshot->numPlayers = engine->n;
+    snapshot->initialX = engine->initialX;
+    snapshot->initialY = engine->initialY;
+    snapshot->x = engine->x;
+    snapshot->y = engine->y;
+    snapshot->reached = engine->reached;
+    snapshot->kicked = engine->kicked;
+    snapshot->challenge = engine->challenge;
+    snapshot->speed = engine->speed;
+    snapshot->dribbling = engine->dribbling;
+    snapshot->kick = engine->kick;
+    snapshot->ball = engine->ball;
+    snapshot->Ascore = engine->Ascore;
+    snapshot->Bscore = engine->Bscore;
+}
@@ -0,0 +1,51 @@
+#ifndef MATCH_SIM_H
+#define MATCH_SIM_H
+
+#include "match_engine.h"
+
+// A whole match in the calling process, played a round at a time, so
+// tools can run many short matches without a launcher or a trace to
+// parse. finishConfig must have been called first.
+typedef struct
+{
+    match_engine engine;
+    int seed;
+    int half, round;        // next round to play, half 2 once the match is over
+} match_sim;
+
+// Read-only view of the engine's own buffers, valid until the next step.
+// Players are in trace order, team A first.
+typedef struct
+{
+    int half, round;        // the round the state is from
+    int numPlayers;
+    const int* initialX;
+    const int* initialY;
+    const int* x;           // where the players ended the round
+    const int* y;
+    const int* reached;
+    const int* kicked;
+    const int* challenge;
+    const int* speed;
+    const int* dribbling;
+    const int* kick;
+    pos ball;
+    int Ascore, Bscore;
+} match_snapshot;
+
+// seed s plays the same match as match_mpi -s s
+void simInit(match_sim* sim, int seed);
+// resumes from a checkpoint of match_mpi or match_smp, returns why it cannot or NULL
+const char* simLoad(match_sim* sim, char* path);
+const char* simSave(match_sim* sim, char* path);
+void simFree(match_sim* sim);
+
+int simFinished(match_sim* sim);
+// plays the next round, kicking off a half first if it starts one
+void simStep(match_sim* sim);
+// plays up to rounds rounds and returns how many were played
+int simRun(match_sim* sim, int rounds);
+// the state after the round last played, half -1 before the first
+void simSnapshot(match_sim* sim, match_snapshot* snapshot);
+
+#endif
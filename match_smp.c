@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "match_sim.h"
+
+void checkpoint(match_sim* sim, char* path);
+
+// Runs a whole match in one process, e.g. OMP_NUM_THREADS=4 ./match_smp
+// The trace is identical to match_mpi with the same seed and configuration
+int main(int argc, char **argv)
+{
+    int round, half, opt;
+    int seed = 0;
+    int every = 0;                  // checkpoint interval in rounds, 0 for none
+    char* checkpointPath = "match.ckpt";
+    char* restartPath = NULL;
+    int output = OUTPUT_TEXT;
+    binary_trace trace;
+    char* summaryPath = NULL;       // in-situ statistics, see match_stats.h
+    match_summary summary;
+    match_sim sim;
+
+    while ((opt = getopt(argc, argv, "s:k:f:x:o:a:" CONFIG_OPTIONS)) != -1)
+    {
+        if (opt == 's') seed = atoi(optarg);
+        else if (opt == 'k') every = atoi(optarg);
+        else if (opt == 'f') checkpointPath = optarg;
+        else if (opt == 'x') restartPath = optarg;
+        else if (opt == 'o' && strcmp(optarg, "text") == 0) output = OUTPUT_TEXT;
+        else if (opt == 'o' && strcmp(optarg, "binary") == 0) output = OUTPUT_BINARY;
+        else if (opt == 'o' && strcmp(optarg, "none") == 0) output = OUTPUT_NONE;
+        else if (opt == 'a') summaryPath = optarg;
+        else if (!parseConfigOption(opt, optarg))
+        {
+            fprintf(stderr, "Usage: %s [-s seed] [-k checkpoint every] [-f checkpoint] [-x restart from] [-o text|binary|none] [-a summary] " CONFIG_USAGE "\n", argv[0]);
+            return 1;
+        }
+    }
+    const char* error = finishConfig();
+    if (error != NULL)
+    {
+        fprintf(stderr, "%s: %s\n", argv[0], error);
+        return 1;
+    }
+
+    // the trace is ~130k lines, so avoid flushing line by line
+    static char buffer[1 << 16];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+    simInit(&sim, seed);
+    if (restartPath != NULL && (error = simLoad(&sim, restartPath)) != NULL)
+    {
+        fprintf(stderr, "%s: %s: %s\n", argv[0], restartPath, error);
+        return 1;
+    }
+    if (output == OUTPUT_BINARY) openTraceWriter(&trace, stdout, &matchLayout, config.numPlayers);
+    if (summaryPath != NULL) initSummary(&summary);
+
+    while (!simFinished(&sim))
+    {
+        match_engine* engine = &sim.engine;
+        half = sim.half;
+        round = sim.round;
+        simStep(&sim);
+        if (output == OUTPUT_BINARY) engineWriteRound(engine, &trace, round);
+        else if (output == OUTPUT_TEXT) enginePrintRound(engine, round);
+        if (summaryPath != NULL) engineTally(engine, &summary.players, round);
+
+        if (sim.round == 0)
+        {
+            if (summaryPath != NULL)
+            {
+                // every player is here, so the tally is the whole match
+                addHalf(&summary, half, engine->Ascore, engine->Bscore, summary.players.kicks, summary.players.numKicks);
+                summary.players.numKicks = 0;
+            }
+            if (DEBUG) printf("Half-time score: A %d:%d B\n", engine->Ascore, engine->Bscore);
+            if (every > 0 && half == 0) checkpoint(&sim, checkpointPath);
+        }
+        else if (every > 0 && sim.round % every == 0) checkpoint(&sim, checkpointPath);
+    }
+    if (DEBUG) printf("Final score: A %d:%d B\n", sim.engine.Ascore, sim.engine.Bscore);
+
+    if (output == OUTPUT_BINARY) closeTrace(&trace);
+    if (summaryPath != NULL)
+    {
+        if ((error = writeSummary(&summary, summaryPath)) != NULL)
+        {
+            fprintf(stderr, "%s: %s\n", summaryPath, error);
+            return 1;
+        }
+        freeSummary(&summary);
+    }
+    simFree(&sim);
+    return 0;
+}
+
+void checkpoint(match_sim* sim, char* path)
+{
+    const char* error = simSave(sim, path);
+    if (error != NULL)
+    {
+        fprintf(stderr, "%s: %s\n", path, error);
+        exit(1);
+    }
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "match_game.h"
+#include "match_stats.h"
+
+static int compareKicks(const void* a, const void* b)
+{
+    return *(const int*) a - *(const int*) b;
+}
+
+void initTally(match_tally* tally, int count)
+{
+    tally->count = count;
+    tally->cells = config.length * config.width;
+    tally->values = calloc((long) count * TALLY_VALUES, sizeof(int));
+    tally->heat = calloc((long) count * tally->cells, sizeof(int));
+    // one player kicks per round at most
+    tally->kicks = malloc(config.rounds * sizeof(int));
+    tally->numKicks = 0;
+}
+
+void freeTally(match_tally* tally)
+{
+    free(tally->values);
+    free(tally->heat);
+    free(tally->kicks);
+}
+
+void tallyPlayer(match_tally* tally, int p, int team, int round, int initialX, int initialY, int finalX, int finalY,
+    int reached, int kicked, int scored)
+{
+    int* values = &tally->values[p * TALLY_VALUES];
+    values[TALLY_KICKS] += kicked;
+    values[TALLY_REACHED] += reached;
+    values[TALLY_DISTANCE] += abs(finalX - initialX) + abs(finalY - initialY);
+    tally->heat[(long) p * tally->cells + finalY * config.length + finalX]++;
+    if (kicked) tally->kicks[tally->numKicks++] = round << 2 | scored << 1 | team;
+}
+
+void initSummary(match_summary* summary)
+{
+    memset(summary, 0, sizeof(match_summary));
+    summary->holder = -1;
+    initTally(&summary->players, config.numPlayers);
+}
+
+void freeSummary(match_summary* summary)
+{
+    freeTally(&summary->players);
+}
+
+// A team has the ball from the round of its kick until the next kick, or
+// nobody has it after a goal, the same rule as engineEndRound. Possession
+// carries over from the last half, so a run resumed from a checkpoint
+// gives the rounds before its first kick to nobody.
+void addHalf(match_summary* summary, int half, int Ascore, int Bscore, int kicks[], int numKicks)
+{
+    int k;
+    int from = 0;
+    qsort(kicks, numKicks, sizeof(int), compareKicks);
+    summary->played[half] = TRUE;
+    summary->score[half][0] = Ascore;
+    summary->score[half][1] = Bscore;
+    for (k = 0; k <= numKicks; k++)
+    {
+        int until = (k < numKicks) ? kicks[k] >> 2 : config.rounds;
+        if (summary->holder >= 0) summary->possession[half][summary->holder] += until - from;
+        if (k == numKicks) break;
+
+        int team = kicks[k] & 1;
+        summary->kicks[half][team]++;
+        summary->holder = (kicks[k] & 2) ? -1 : team;
+        from = until;
+    }
+}
+
+// One line per half, the possession of the whole run, a line of counters
+// per player and a line per player listing the cells it ended rounds on
+// as cell:rounds, cell being y * length + x
+const char* writeSummary(match_summary* summary, char* path)
+{
+    int half, p, c;
+    long possession[2] = {0, 0};
+    match_tally* players = &summary->players;
+    FILE* file = fopen(path, "w");
+    if (file == NULL) return "cannot write the summary";
+
+    for (half = 0; half < 2; half++)
+    {
+        if (!summary->played[half]) continue;
+        fprintf(file, "half %d score %d %d kicks %d %d possession %ld %ld\n", half + 1,
+            summary->score[half][0], summary->score[half][1], summary->kicks[half][0], summary->kicks[half][1],
+            summary->possession[half][0], summary->possession[half][1]);
+        possession[0] += summary->possession[half][0];
+        possession[1] += summary->possession[half][1];
+    }
+    if (possession[0] + possession[1] > 0)
+    {
+        fprintf(file, "possession %.1f %.1f\n", 100.0 * possession[0] / (possession[0] + possession[1]),
+            100.0 * possession[1] / (possession[0] + possession[1]));
+    }
+
+    for (p = 0; p < players->count; p++)
+    {
+        int* values = &players->values[p * TALLY_VALUES];
+        fprintf(file, "player %c %d kicks %d reached %d distance %d\n", p < config.teamSize ? 'A' : 'B',
+            p % config.teamSize, values[TALLY_KICKS], values[TALLY_REACHED], values[TALLY_DISTANCE]);
+    }
+    for (p = 0; p < players->count; p++)
+    {
+        int* heat = &players->heat[(long) p * players->cells];
+        fprintf(file, "heat %c %d", p < config.teamSize ? 'A' : 'B', p % config.teamSize);
+        for (c = 0; c < players->cells; c++)
+        {
+            if (heat[c] > 0) fprintf(file, " %d:%d", c, heat[c]);
+        }
+        fprintf(file, "\n");
+    }
+
+    if (fclose(file) != 0) return "cannot write the summary";
+    return NULL;
+}
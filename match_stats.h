@@ -0,0 +1,49 @@
+#ifndef MATCH_STATS_H
+#define MATCH_STATS_H
+
+// counters per player
+#define TALLY_KICKS 0
+#define TALLY_REACHED 1
+#define TALLY_DISTANCE 2
+#define TALLY_VALUES 3
+
+// What a rank counts during the run for the players it plays: counters
+// and a heatmap of the cells the players end their rounds on. The kicks of
+// the half being played are kept as round << 2 | scored << 1 | team, B
+// being 1, so possession can be worked out once every rank's kicks are
+// put together.
+typedef struct
+{
+    int count;                  // players
+    int cells;                  // length * width
+    int* values;                // TALLY_VALUES per player
+    int* heat;                  // cells per player, y * length + x
+    int* kicks;
+    int numKicks;
+} match_tally;
+
+// The tallies of every rank put together, players in trace order
+typedef struct
+{
+    int played[2];              // halves this run played some of
+    int score[2][2];            // A and B at the end of each half
+    int kicks[2][2];            // per half, A and B
+    long possession[2][2];      // rounds a team ended in possession, as match_engine.h counts them
+    int holder;                 // team in possession after the last half added, -1 for nobody
+    match_tally players;
+} match_summary;
+
+void initTally(match_tally* tally, int count);
+void freeTally(match_tally* tally);
+void tallyPlayer(match_tally* tally, int p, int team, int round, int initialX, int initialY, int finalX, int finalY,
+    int reached, int kicked, int scored);
+
+void initSummary(match_summary* summary);
+void freeSummary(match_summary* summary);
+// the kicks of a half, from every rank and in any order
+void addHalf(match_summary* summary, int half, int Ascore, int Bscore, int kicks[], int numKicks);
+
+// returns why the summary cannot be written or NULL
+const char* writeSummary(match_summary* summary, char* path);
+
+#endif
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "match_live.h"
+
+void printRound(live_round* round, pos positions[], int numPlayers, int players);
+
+// Follows a match that publishes its rounds with -l, e.g.
+// mpirun -n 34 match_mpi -o none -l /match_live and ./match_view -p
+// The viewer only reads the shared memory, so it can be started and
+// stopped at any time. By default it prints the latest round each time it
+// looks, with -a every round, counting those it was too slow for.
+int main(int argc, char **argv)
+{
+    int opt;
+    char* name = LIVE_DEFAULT;
+    int players = 0;
+    int all = 0;
+    int interval = 100;             // ms between looks
+    unsigned long next, published, lost = 0;
+    const char* error;
+    const char* waiting = NULL;
+    match_live live;
+    live_round round;
+
+    while ((opt = getopt(argc, argv, "l:pai:")) != -1)
+    {
+        if (opt == 'l') name = optarg;
+        else if (opt == 'p') players = 1;
+        else if (opt == 'a') all = 1;
+        else if (opt == 'i' && atoi(optarg) > 0) interval = atoi(optarg);
+        else
+        {
+            fprintf(stderr, "Usage: %s [-l live name] [-p] [-a] [-i interval ms]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // the match may not have started yet
+    while ((error = attachLive(&live, name)) != NULL)
+    {
+        if (waiting != error) fprintf(stderr, "%s: %s, waiting\n", name, error);
+        waiting = error;
+        usleep(interval * 1000);
+    }
+
+    int numPlayers = live.header->numPlayers;
+    pos* positions = malloc(numPlayers * sizeof(pos));
+    // -a starts with the oldest round the ring still holds
+    next = atomic_load_explicit(&live.header->published, memory_order_acquire);
+    if (all) next = next > LIVE_SLOTS ? next - LIVE_SLOTS : 0;
+    else if (next > 0) next--;
+    for (;;)
+    {
+        // a finished match has published everything it will
+        int finished = atomic_load_explicit(&live.header->state, memory_order_acquire) == LIVE_FINISHED;
+        published = atomic_load_explicit(&live.header->published, memory_order_acquire);
+        if (published > next)
+        {
+            if (!all) next = published - 1;
+            else if (published - next > LIVE_SLOTS)
+            {
+                lost += published - LIVE_SLOTS - next;
+                next = published - LIVE_SLOTS;
+            }
+            for (; next < published; next++)
+            {
+                if (readLive(&live, next, &round, positions)) printRound(&round, positions, numPlayers, players);
+                else lost++;
+            }
+            fflush(stdout);
+        }
+        else if (finished) break;
+        else usleep(interval * 1000);
+    }
+    if (all && lost > 0) fprintf(stderr, "%s: %lu rounds were overwritten before they were read\n", name, lost);
+
+    detachLive(&live);
+    free(positions);
+    return 0;
+}
+
+void printRound(live_round* round, pos positions[], int numPlayers, int players)
+{
+    int p;
+    printf("half %d round %d ball %d %d score A %d:%d B\n", round->half + 1, round->round,
+        round->ballX, round->ballY, round->Ascore, round->Bscore);
+    if (!players) return;
+    for (p = 0; p < numPlayers; p++) printf("%d %d %d\n", p, positions[p].x, positions[p].y);
+}
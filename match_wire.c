@@ -0,0 +1,54 @@
+#include "match_wire.h"
+
+static int wide(void)
+{
+    return config.length > 256 || config.width > 256;
+}
+
+static unsigned char* putCoord(unsigned char* out, int value)
+{
+    *out++ = value & 0xff;
+    if (wide()) *out++ = value >> 8;
+    return out;
+}
+
+static const unsigned char* getCoord(const unsigned char* in, int* value)
+{
+    *value = *in++;
+    if (wide()) *value |= *in++ << 8;
+    return in;
+}
+
+int wireSize(int kickOff)
+{
+    int coords = kickOff ? 4 : 2;
+    return coords * (wide() ? 2 : 1) + 1;
+}
+
+// a challenge is at most 9 * dribbling, which leaves 6 bits plenty
+void packPlayer(football_player* player, int kickOff, unsigned char* out)
+{
+    if (kickOff)
+    {
+        out = putCoord(out, player->initial.x);
+        out = putCoord(out, player->initial.y);
+    }
+    out = putCoord(out, player->final.x);
+    out = putCoord(out, player->final.y);
+    *out = player->reached | player->kicked << 1 | (player->challenge + 1) << 2;
+}
+
+void unpackPlayer(const unsigned char* in, int kickOff, football_player* player)
+{
+    if (kickOff)
+    {
+        in = getCoord(in, &player->initial.x);
+        in = getCoord(in, &player->initial.y);
+    }
+    else player->initial = player->final;
+    in = getCoord(in, &player->final.x);
+    in = getCoord(in, &player->final.y);
+    player->reached = *in & 1;
+    player->kicked = (*in >> 1) & 1;
+    player->challenge = (*in >> 2) - 1;
+}
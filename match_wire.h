@@ -0,0 +1,22 @@
+#ifndef MATCH_WIRE_H
+#define MATCH_WIRE_H
+
+#include "match_game.h"
+
+// Compact reports. FP0 gets every player whole once, then each round only
+// what a round changes, packed into a few bytes per player:
+//   final x, final y   a byte each, two on fields over 256 long or wide
+//   events             reached | kicked << 1 | (challenge + 1) << 2
+// A round starts where the last one ended, so the initial position is
+// only sent in the first round of a half, after the kick-off moved everyone.
+// The attributes never change after initPlayers and are never sent again.
+
+#define MAX_WIRE_SIZE 9       // a kick-off round on a wide field
+
+// bytes per player in a round, the same on every rank
+int wireSize(int kickOff);
+void packPlayer(football_player* player, int kickOff, unsigned char* out);
+// updates what FP0 knows of the player with a round
+void unpackPlayer(const unsigned char* in, int kickOff, football_player* player);
+
+#endif
@@ -0,0 +1,380 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpi_profile.h"
+
+#define PROFILE_SUMMARY 1
+#define PROFILE_CSV 2
+
+#define PROFILE_FIELDS 5
+
+typedef struct
+{
+    double time;            // wall time spent in the phase
+    double mpiTime;         // part of it spent inside MPI
+    double calls;
+    double sent;            // bytes this rank contributed
+    double received;        // bytes this rank ended up with
+} phase_profile;
+
+int profileEnabled = 0;
+int profileFormat;
+int numPhases = 1;
+int currentPhase = 0;
+double phaseStart;
+const char* phaseNames[MAX_PROFILE_PHASES] = {"run"};
+phase_profile phases[MAX_PROFILE_PHASES];
+
+void startProfile(void);
+void printProfile(void);
+double typeBytes(int count, MPI_Datatype type);
+void charge(double start, double sent, double received);
+
+void profilePhases(const char* names[], int count)
+{
+    int p;
+    if (count > MAX_PROFILE_PHASES) count = MAX_PROFILE_PHASES;
+    for (p = 0; p < count; p++) phaseNames[p] = names[p];
+    numPhases = count;
+}
+
+int profileSwitch(int phase)
+{
+    double now = PMPI_Wtime();
+    int previous = currentPhase;
+    phases[currentPhase].time += now - phaseStart;
+    phaseStart = now;
+    currentPhase = phase;
+    return previous;
+}
+
+void startProfile(void)
+{
+    char* format = getenv("PROFILE_MPI");
+    if (format == NULL) return;
+    if (strcmp(format, "summary") == 0) profileFormat = PROFILE_SUMMARY;
+    else if (strcmp(format, "csv") == 0) profileFormat = PROFILE_CSV;
+    else return;
+
+    memset(phases, 0, sizeof(phases));
+    currentPhase = 0;
+    phaseStart = PMPI_Wtime();
+    profileEnabled = 1;
+}
+
+double typeBytes(int count, MPI_Datatype type)
+{
+    int size;
+    PMPI_Type_size(type, &size);
+    return (double) count * size;
+}
+
+void charge(double start, double sent, double received)
+{
+    phase_profile* phase = &phases[currentPhase];
+    phase->mpiTime += PMPI_Wtime() - start;
+    phase->calls++;
+    phase->sent += sent;
+    phase->received += received;
+}
+
+// Rank 0 collects every rank's phases. Ranks that finalize early wait here
+// for the rest, which does not change what they recorded.
+void printProfile(void)
+{
+    int rank, size, r, p;
+    double* all = NULL;
+
+    profileSwitch(currentPhase);
+    PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &size);
+    if (rank == 0) all = malloc(size * MAX_PROFILE_PHASES * sizeof(phase_profile));
+    PMPI_Gather(phases, MAX_PROFILE_PHASES * PROFILE_FIELDS, MPI_DOUBLE, all, MAX_PROFILE_PHASES * PROFILE_FIELDS,
+        MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (rank != 0) return;
+
+    phase_profile* ranks = (phase_profile*) all;
+    if (profileFormat == PROFILE_CSV)
+    {
+        fprintf(stderr, "rank,phase,time,mpi_time,calls,bytes_sent,bytes_received\n");
+        for (r = 0; r < size; r++)
+        {
+            for (p = 0; p < numPhases; p++)
+            {
+                phase_profile* phase = &ranks[r * MAX_PROFILE_PHASES + p];
+                fprintf(stderr, "%d,%s,%.6f,%.6f,%.0f,%.0f,%.0f\n", r, phaseNames[p], phase->time, phase->mpiTime,
+                    phase->calls, phase->sent, phase->received);
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "%-12s %10s %10s %10s %12s %14s %14s\n", "phase", "max s", "mean s", "mpi mean s",
+            "calls/rank", "sent B/rank", "recv B/rank");
+        for (p = 0; p < numPhases; p++)
+        {
+            phase_profile total = {0, 0, 0, 0, 0};
+            double maxTime = 0;
+            for (r = 0; r < size; r++)
+            {
+                phase_profile* phase = &ranks[r * MAX_PROFILE_PHASES + p];
+                if (phase->time > maxTime) maxTime = phase->time;
+                total.time += phase->time;
+                total.mpiTime += phase->mpiTime;
+                total.calls += phase->calls;
+                total.sent += phase->sent;
+                total.received += phase->received;
+            }
+            fprintf(stderr, "%-12s %10.4f %10.4f %10.4f %12.0f %14.0f %14.0f\n", phaseNames[p], maxTime,
+                total.time / size, total.mpiTime / size, total.calls / size, total.sent / size, total.received / size);
+        }
+    }
+    free(all);
+}
+
+int MPI_Init(int *argc, char ***argv)
+{
+    int result = PMPI_Init(argc, argv);
+    startProfile();
+    return result;
+}
+
+int MPI_Init_thread(int *argc, char ***argv, int required, int *provided)
+{
+    int result = PMPI_Init_thread(argc, argv, required, provided);
+    startProfile();
+    return result;
+}
+
+int MPI_Finalize(void)
+{
+    if (profileEnabled) printProfile();
+    return PMPI_Finalize();
+}
+
+int MPI_Send(const void *buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Send(buf, count, datatype, dest, tag, comm);
+    double start = PMPI_Wtime();
+    int result = PMPI_Send(buf, count, datatype, dest, tag, comm);
+    charge(start, typeBytes(count, datatype), 0);
+    return result;
+}
+
+int MPI_Recv(void *buf, int count, MPI_Datatype datatype, int source, int tag, MPI_Comm comm, MPI_Status *status)
+{
+    if (!profileEnabled) return PMPI_Recv(buf, count, datatype, source, tag, comm, status);
+    MPI_Status local;
+    double start = PMPI_Wtime();
+    int result = PMPI_Recv(buf, count, datatype, source, tag, comm, &local);
+    int bytes;
+    PMPI_Get_count(&local, MPI_BYTE, &bytes);
+    charge(start, 0, bytes);
+    if (status != MPI_STATUS_IGNORE) *status = local;
+    return result;
+}
+
+int MPI_Bcast(void *buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Bcast(buffer, count, datatype, root, comm);
+    int rank;
+    double start = PMPI_Wtime();
+    int result = PMPI_Bcast(buffer, count, datatype, root, comm);
+    PMPI_Comm_rank(comm, &rank);
+    if (rank == root) charge(start, typeBytes(count, datatype), 0);
+    else charge(start, 0, typeBytes(count, datatype));
+    return result;
+}
+
+int MPI_Gather(const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf, int recvcount,
+    MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    int rank, size;
+    double start = PMPI_Wtime();
+    int result = PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    double sent = (sendbuf == MPI_IN_PLACE) ? 0 : typeBytes(sendcount, sendtype);
+    charge(start, sent, rank == root ? typeBytes(recvcount, recvtype) * size : 0);
+    return result;
+}
+
+int MPI_Igather(const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf, int recvcount,
+    MPI_Datatype recvtype, int root, MPI_Comm comm, MPI_Request *request)
+{
+    if (!profileEnabled) return PMPI_Igather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, request);
+    int rank, size;
+    double start = PMPI_Wtime();
+    int result = PMPI_Igather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm, request);
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    double sent = (sendbuf == MPI_IN_PLACE) ? 0 : typeBytes(sendcount, sendtype);
+    charge(start, sent, rank == root ? typeBytes(recvcount, recvtype) * size : 0);
+    return result;
+}
+
+int MPI_Gatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf, const int recvcounts[],
+    const int displs[], MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+    int rank, size, r;
+    double received = 0;
+    double start = PMPI_Wtime();
+    int result = PMPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    for (r = 0; rank == root && r < size; r++) received += typeBytes(recvcounts[r], recvtype);
+    charge(start, (sendbuf == MPI_IN_PLACE) ? 0 : typeBytes(sendcount, sendtype), received);
+    return result;
+}
+
+int MPI_Allgatherv(const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf, const int recvcounts[],
+    const int displs[], MPI_Datatype recvtype, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Allgatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, comm);
+    int size, r;
+    double received = 0;
+    double start = PMPI_Wtime();
+    int result = PMPI_Allgatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, comm);
+    PMPI_Comm_size(comm, &size);
+    for (r = 0; r < size; r++) received += typeBytes(recvcounts[r], recvtype);
+    charge(start, (sendbuf == MPI_IN_PLACE) ? 0 : typeBytes(sendcount, sendtype), received);
+    return result;
+}
+
+int MPI_Scatter(const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf, int recvcount,
+    MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Scatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    int rank, size;
+    double start = PMPI_Wtime();
+    int result = PMPI_Scatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    double received = (recvbuf == MPI_IN_PLACE) ? 0 : typeBytes(recvcount, recvtype);
+    charge(start, rank == root ? typeBytes(sendcount, sendtype) * size : 0, received);
+    return result;
+}
+
+int MPI_Scatterv(const void *sendbuf, const int sendcounts[], const int displs[], MPI_Datatype sendtype,
+    void *recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Scatterv(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    int rank, size, r;
+    double sent = 0;
+    double start = PMPI_Wtime();
+    int result = PMPI_Scatterv(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm);
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &size);
+    for (r = 0; rank == root && r < size; r++) sent += typeBytes(sendcounts[r], sendtype);
+    charge(start, sent, (recvbuf == MPI_IN_PLACE) ? 0 : typeBytes(recvcount, recvtype));
+    return result;
+}
+
+int MPI_Allgather(const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf, int recvcount,
+    MPI_Datatype recvtype, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+    int size;
+    double start = PMPI_Wtime();
+    int result = PMPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+    PMPI_Comm_size(comm, &size);
+    charge(start, (sendbuf == MPI_IN_PLACE) ? 0 : typeBytes(sendcount, sendtype), typeBytes(recvcount, recvtype) * size);
+    return result;
+}
+
+int MPI_Allreduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    double start = PMPI_Wtime();
+    int result = PMPI_Allreduce(sendbuf, recvbuf, count, datatype, op, comm);
+    charge(start, typeBytes(count, datatype), typeBytes(count, datatype));
+    return result;
+}
+
+int MPI_Reduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
+    int rank;
+    double start = PMPI_Wtime();
+    int result = PMPI_Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
+    PMPI_Comm_rank(comm, &rank);
+    charge(start, typeBytes(count, datatype), rank == root ? typeBytes(count, datatype) : 0);
+    return result;
+}
+
+int MPI_Exscan(const void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Exscan(sendbuf, recvbuf, count, datatype, op, comm);
+    double start = PMPI_Wtime();
+    int result = PMPI_Exscan(sendbuf, recvbuf, count, datatype, op, comm);
+    charge(start, typeBytes(count, datatype), typeBytes(count, datatype));
+    return result;
+}
+
+int MPI_Neighbor_alltoall(const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf, int recvcount,
+    MPI_Datatype recvtype, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Neighbor_alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+    int indegree, outdegree, weighted;
+    double start = PMPI_Wtime();
+    int result = PMPI_Neighbor_alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm);
+    PMPI_Dist_graph_neighbors_count(comm, &indegree, &outdegree, &weighted);
+    charge(start, typeBytes(sendcount, sendtype) * outdegree, typeBytes(recvcount, recvtype) * indegree);
+    return result;
+}
+
+int MPI_Neighbor_alltoallv(const void *sendbuf, const int sendcounts[], const int sdispls[], MPI_Datatype sendtype,
+    void *recvbuf, const int recvcounts[], const int rdispls[], MPI_Datatype recvtype, MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Neighbor_alltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, comm);
+    int indegree, outdegree, weighted, n;
+    double sent = 0, received = 0;
+    double start = PMPI_Wtime();
+    int result = PMPI_Neighbor_alltoallv(sendbuf, sendcounts, sdispls, sendtype, recvbuf, recvcounts, rdispls, recvtype, comm);
+    PMPI_Dist_graph_neighbors_count(comm, &indegree, &outdegree, &weighted);
+    for (n = 0; n < outdegree; n++) sent += typeBytes(sendcounts[n], sendtype);
+    for (n = 0; n < indegree; n++) received += typeBytes(recvcounts[n], recvtype);
+    charge(start, sent, received);
+    return result;
+}
+
+int MPI_Wait(MPI_Request *request, MPI_Status *status)
+{
+    if (!profileEnabled) return PMPI_Wait(request, status);
+    double start = PMPI_Wtime();
+    int result = PMPI_Wait(request, status);
+    charge(start, 0, 0);
+    return result;
+}
+
+int MPI_Barrier(MPI_Comm comm)
+{
+    if (!profileEnabled) return PMPI_Barrier(comm);
+    double start = PMPI_Wtime();
+    int result = PMPI_Barrier(comm);
+    charge(start, 0, 0);
+    return result;
+}
+
+// bytes written count as sent
+int MPI_File_write_all(MPI_File fh, const void *buf, int count, MPI_Datatype datatype, MPI_Status *status)
+{
+    if (!profileEnabled) return PMPI_File_write_all(fh, buf, count, datatype, status);
+    double start = PMPI_Wtime();
+    int result = PMPI_File_write_all(fh, buf, count, datatype, status);
+    charge(start, typeBytes(count, datatype), 0);
+    return result;
+}
+
+int MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm *newcomm)
+{
+    if (!profileEnabled) return PMPI_Comm_split(comm, color, key, newcomm);
+    double start = PMPI_Wtime();
+    int result = PMPI_Comm_split(comm, color, key, newcomm);
+    charge(start, 0, 0);
+    return result;
+}
@@ -0,0 +1,25 @@
+#ifndef MPI_PROFILE_H
+#define MPI_PROFILE_H
+
+// Per-phase profiling through the MPI profiling interface. Linking
+// mpi_profile.c wraps the MPI calls the programs make and, when the
+// environment variable PROFILE_MPI is "summary" or "csv", charges their
+// time, call count and bytes to the phase the rank is in. At MPI_Finalize
+// rank 0 prints a summary or one CSV row per rank and phase on stderr.
+// When PROFILE_MPI is unset every wrapper and phase switch costs a branch.
+
+#define MAX_PROFILE_PHASES 16
+
+extern int profileEnabled;
+
+// names[0] is the phase every rank starts in
+void profilePhases(const char* names[], int count);
+int profileSwitch(int phase);
+
+#define PROFILE_PHASE(phase) do { if (profileEnabled) profileSwitch(phase); } while (0)
+
+// switches like PROFILE_PHASE and evaluates to the phase that was running,
+// so a section nested in others can switch back when it is done
+#define PROFILE_NESTED(phase) (profileEnabled ? profileSwitch(phase) : 0)
+
+#endif
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parallel_trace.h"
+
+#define MAX_INT_TEXT 12     // "-2147483648 "
+
+static char* reserve(parallel_trace* trace, long bytes)
+{
+    if (trace->used + bytes > trace->size)
+    {
+        trace->size = 2 * (trace->used + bytes);
+        trace->buffer = realloc(trace->buffer, trace->size);
+    }
+    return trace->buffer + trace->used;
+}
+
+const char* openParallelTrace(parallel_trace* trace, MPI_Comm comm, char* path, const trace_layout* layout)
+{
+    trace->comm = comm;
+    trace->layout = layout;
+    trace->base = 0;
+    trace->rounds = 0;
+    trace->bytes[0] = 0;
+    trace->bytes[1] = 0;
+    trace->used = 0;
+    trace->size = 0;
+    trace->buffer = NULL;
+    MPI_Comm_rank(comm, &trace->rank);
+    if (MPI_File_open(comm, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &trace->file) != MPI_SUCCESS)
+    {
+        return "cannot write the trace";
+    }
+    MPI_File_set_size(trace->file, 0);
+    return NULL;
+}
+
+void addTraceHeader(parallel_trace* trace, int round, int ballX, int ballY)
+{
+    char* at = reserve(trace, 4 * MAX_INT_TEXT);
+    long length = sprintf(at, "%d\n%d %d\n", round, ballX, ballY);
+    trace->used += length;
+    trace->bytes[2 * trace->rounds] += length;
+}
+
+void addTraceLines(parallel_trace* trace, const int values[], int count)
+{
+    int i, p, fields = trace->layout->fields;
+    char* start = reserve(trace, (long) count * (fields * MAX_INT_TEXT + 1));
+    char* at = start;
+    for (p = 0; p < count; p++)
+    {
+        for (i = 0; i < fields; i++) at += sprintf(at, "%d ", values[p * fields + i]);
+        *at++ = '\n';
+    }
+    trace->used += at - start;
+    trace->bytes[2 * trace->rounds + 1] += at - start;
+}
+
+void endTraceRound(parallel_trace* trace)
+{
+    trace->rounds++;
+    if (trace->rounds == PARALLEL_BATCH) flushParallelTrace(trace);
+    else
+    {
+        trace->bytes[2 * trace->rounds] = 0;
+        trace->bytes[2 * trace->rounds + 1] = 0;
+    }
+}
+
+// Each round is its header followed by the lines of every rank, so a
+// rank's lines go after the header and the lines of the ranks before it
+void flushParallelTrace(parallel_trace* trace)
+{
+    int r, blocks = 0, n = trace->rounds;
+    long before[2 * PARALLEL_BATCH], totals[2 * PARALLEL_BATCH];
+    int lengths[2 * PARALLEL_BATCH];
+    MPI_Aint displs[2 * PARALLEL_BATCH];
+    MPI_Aint at = 0;
+    MPI_Datatype view = MPI_CHAR;
+
+    if (n == 0) return;
+    MPI_Exscan(trace->bytes, before, 2 * n, MPI_LONG, MPI_SUM, trace->comm);
+    if (trace->rank == 0) memset(before, 0, 2 * n * sizeof(long));
+    MPI_Allreduce(trace->bytes, totals, 2 * n, MPI_LONG, MPI_SUM, trace->comm);
+
+    for (r = 0; r < n; r++)
+    {
+        if (trace->bytes[2 * r] > 0)
+        {
+            displs[blocks] = at;
+            lengths[blocks++] = (int) trace->bytes[2 * r];
+        }
+        if (trace->bytes[2 * r + 1] > 0)
+        {
+            displs[blocks] = at + totals[2 * r] + before[2 * r + 1];
+            lengths[blocks++] = (int) trace->bytes[2 * r + 1];
+        }
+        at += totals[2 * r] + totals[2 * r + 1];
+    }
+
+    // a rank with nothing to write still takes part, with a plain view
+    if (blocks > 0)
+    {
+        MPI_Type_create_hindexed(blocks, lengths, displs, MPI_CHAR, &view);
+        MPI_Type_commit(&view);
+    }
+    MPI_File_set_view(trace->file, trace->base, MPI_CHAR, view, "native", MPI_INFO_NULL);
+    MPI_File_write_all(trace->file, trace->buffer, (int) trace->used, MPI_CHAR, MPI_STATUS_IGNORE);
+    if (blocks > 0) MPI_Type_free(&view);
+
+    trace->base += at;
+    trace->used = 0;
+    trace->rounds = 0;
+    trace->bytes[0] = 0;
+    trace->bytes[1] = 0;
+}
+
+void closeParallelTrace(parallel_trace* trace)
+{
+    flushParallelTrace(trace);
+    MPI_File_close(&trace->file);
+    free(trace->buffer);
+}
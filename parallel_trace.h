@@ -0,0 +1,39 @@
+#ifndef PARALLEL_TRACE_H
+#define PARALLEL_TRACE_H
+
+#include <mpi.h>
+
+#include "binary_trace.h"
+
+#define PARALLEL_BATCH 64       // rounds per collective write
+
+// Every rank formats its own part of each round and the parts go into one
+// text trace with collective MPI-IO, so no rank formats or writes for the
+// others. A round is its header, added by a rank that knows the ball, then
+// the player lines of every rank in rank order. Offsets come from a prefix
+// sum over the bytes each rank added, once per batch of rounds.
+typedef struct
+{
+    MPI_Comm comm;
+    int rank;
+    MPI_File file;
+    const trace_layout* layout;
+    MPI_Offset base;                    // where the batch goes
+    int rounds;                         // rounds in the batch
+    long bytes[2 * PARALLEL_BATCH];     // header and line bytes this rank added to each
+    char* buffer;
+    long used, size;
+} parallel_trace;
+
+// collective, returns why the file cannot be written or NULL
+const char* openParallelTrace(parallel_trace* trace, MPI_Comm comm, char* path, const trace_layout* layout);
+
+void addTraceHeader(parallel_trace* trace, int round, int ballX, int ballY);
+void addTraceLines(parallel_trace* trace, const int values[], int count);
+
+// collective, every rank ends every round, whether it added to it or not
+void endTraceRound(parallel_trace* trace);
+void flushParallelTrace(parallel_trace* trace);
+void closeParallelTrace(parallel_trace* trace);
+
+#endif
@@ -0,0 +1,84 @@
+#include "rng.h"
+
+void seedRandom(rand_stream* stream, unsigned int seed)
+{
+    int i;
+    int32_t word;
+
+    stream->mode = RNG_LIBC;
+
+    // glibc treats seed 0 as seed 1
+    if (seed == 0) seed = 1;
+    stream->table[0] = (int32_t) seed;
+    word = (int32_t) seed;
+    for (i = 1; i < RAND_DEG; i++)
+    {
+        // word = (16807 * word) % 2147483647 without overflowing 31 bits
+        int32_t hi = word / 127773;
+        int32_t lo = word % 127773;
+        word = 16807 * lo - 2836 * hi;
+        if (word < 0) word += 2147483647;
+        stream->table[i] = word;
+    }
+    stream->front = RAND_SEP;
+    stream->rear = 0;
+
+    // discard the first 10 * RAND_DEG values like srandom_r does
+    for (i = 0; i < 10 * RAND_DEG; i++)
+    {
+        nextRandom(stream);
+    }
+}
+
+int nextRandom(rand_stream* stream)
+{
+    uint32_t value = (uint32_t) stream->table[stream->front] + (uint32_t) stream->table[stream->rear];
+    stream->table[stream->front] = (int32_t) value;
+
+    if (++stream->front >= RAND_DEG) stream->front = 0;
+    if (++stream->rear >= RAND_DEG) stream->rear = 0;
+
+    return (int) (value >> 1);
+}
+
+void seedCounter(rand_stream* stream, uint32_t seed, uint32_t entity)
+{
+    stream->mode = RNG_PHILOX;
+    stream->seed = seed;
+    stream->entity = entity;
+    stream->round = 0;
+}
+
+void setRandomRound(rand_stream* stream, uint32_t round)
+{
+    stream->round = round;
+}
+
+// Same range as rand(), whichever generator the stream uses
+int drawRandom(rand_stream* stream, int purpose)
+{
+    if (stream->mode == RNG_LIBC) return nextRandom(stream);
+    return (int) (philox(stream->seed, stream->entity, stream->round, (uint32_t) purpose) >> 1);
+}
+
+// First word of Philox4x32-10 (Salmon et al., SC'11) with key (seed, entity)
+// and counter (round, purpose, 0, 0)
+uint32_t philox(uint32_t seed, uint32_t entity, uint32_t round, uint32_t purpose)
+{
+    int i;
+    uint32_t c0 = round, c1 = purpose, c2 = 0, c3 = 0;
+    uint32_t k0 = seed, k1 = entity;
+
+    for (i = 0; i < 10; i++)
+    {
+        uint64_t p0 = (uint64_t) 0xD2511F53 * c0;
+        uint64_t p1 = (uint64_t) 0xCD9E8D57 * c2;
+        c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t) p1;
+        c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t) p0;
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+    return c0;
+}
@@ -0,0 +1,45 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Number of words in the additive feedback table used by glibc rand()
+#define RAND_DEG 31
+#define RAND_SEP 3
+
+// generators
+#define RNG_LIBC 0      // glibc rand() sequence per entity, reproduces the reference traces
+#define RNG_PHILOX 1    // Philox4x32-10 keyed on (seed, entity), counter (round, purpose)
+
+// what a draw is for, so counter-based draws never depend on call order
+#define DRAW_X 0
+#define DRAW_Y 1
+#define DRAW_CHALLENGE 2
+#define DRAW_DIRECTION 3
+#define DRAW_KICKER 4
+
+// A private random stream for one entity (player or field), so every
+// entity owns its sequence regardless of which process or thread runs it.
+// RNG_LIBC reproduces srand(seed)/rand() from glibc bit for bit, which
+// still depends on how many draws came before. RNG_PHILOX draws are a pure
+// function of (seed, entity, round, purpose).
+typedef struct
+{
+    int mode;
+    uint32_t seed;
+    uint32_t entity;
+    uint32_t round;         // set with setRandomRound, RNG_PHILOX only
+
+    int32_t table[RAND_DEG];
+    int front;
+    int rear;
+} rand_stream;
+
+void seedRandom(rand_stream* stream, unsigned int seed);
+void seedCounter(rand_stream* stream, uint32_t seed, uint32_t entity);
+void setRandomRound(rand_stream* stream, uint32_t round);
+int nextRandom(rand_stream* stream);
+int drawRandom(rand_stream* stream, int purpose);
+uint32_t philox(uint32_t seed, uint32_t entity, uint32_t round, uint32_t purpose);
+
+#endif
@@ -0,0 +1,181 @@
+#!/bin/bash
+# Strong and weak scaling of the whole simulators, traces off.
+#
+#   ./scaling_bench.sh [-o results.csv] [-r repeats] [-q] [-l label] [-b build dir]
+#   ./scaling_bench.sh -c before.csv after.csv
+#
+# Every configuration of the matrix below is run repeats times on this
+# machine, oversubscribed if need be. The MPI runs have PROFILE_MPI=csv
+# (see mpi_profile.h), so their run time is the slowest rank's time from
+# MPI_Init to MPI_Finalize and each phase gets its slowest rank's time and
+# mean MPI time. The smp runs only have the wall time, process start-up
+# included, so they compare with each other rather than with MPI runs.
+#
+# Results are appended to the CSV one value per line:
+#   label,suite,program,protocol,ranks,threads,players,field,rounds,repeat,metric,value
+# with label the commit by default. -c prints the best rounds/s of each
+# configuration in two result files and the ratio of the second to the first.
+#
+# Suites:
+#   strong  same match or training on more ranks or threads
+#   weak    players grow with the ranks or threads
+#   field   match_mpi with the same players on a larger field
+# -q runs a shorter match and fewer configurations, for a quick check.
+
+set -eu
+
+BUILD=build
+OUTPUT=scaling.csv
+REPEATS=3
+QUICK=0
+LABEL=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+MPIRUN="mpirun --oversubscribe"
+if [ "$(id -u)" = 0 ]; then MPIRUN="$MPIRUN --allow-run-as-root"; fi
+
+compare()
+{
+    # best rounds/s per configuration, keyed on everything but label and repeat
+    awk -F, '
+        FNR == 1 { file++ }
+        $11 != "rounds_per_s" { next }
+        {
+            key = $2 "," $3 "," $4 "," $5 "," $6 "," $7 "," $8 "," $9
+            if (!(key in seen)) { seen[key] = 1; order[++count] = key }
+            if ($12 > best[file, key]) best[file, key] = $12
+        }
+        END {
+            printf "%-60s %12s %12s %8s\n", "suite,program,protocol,ranks,threads,players,field,rounds", "before", "after", "ratio"
+            for (k = 1; k <= count; k++)
+            {
+                key = order[k]
+                if (best[1, key] > 0 && best[2, key] > 0)
+                    printf "%-60s %12.1f %12.1f %8.3f\n", key, best[1, key], best[2, key], best[2, key] / best[1, key]
+            }
+        }' "$1" "$2"
+}
+
+while getopts "o:r:ql:b:c" opt; do
+    case $opt in
+        o) OUTPUT=$OPTARG ;;
+        r) REPEATS=$OPTARG ;;
+        q) QUICK=1 ;;
+        l) LABEL=$OPTARG ;;
+        b) BUILD=$OPTARG ;;
+        c) shift $((OPTIND - 1))
+           if [ $# -ne 2 ]; then echo "Usage: $0 -c before.csv after.csv" >&2; exit 1; fi
+           compare "$1" "$2"
+           exit 0 ;;
+        *) echo "Usage: $0 [-o results.csv] [-r repeats] [-q] [-l label] [-b build dir] | -c before.csv after.csv" >&2; exit 1 ;;
+    esac
+done
+
+if [ $QUICK = 1 ]; then
+    HALF=300            # rounds per half
+    HOSTED="1 2 4"
+    GRIDS="1x2 3x4"
+    FIELDS="48x64 96x128"
+    THREADS="1 2"
+    HOSTS="2 3 5"
+else
+    HALF=2700
+    HOSTED="1 2 4 8 16"
+    GRIDS="1x2 2x2 3x4 4x4"
+    FIELDS="48x64 96x128 192x256 384x512"
+    THREADS="1 2 4 8"
+    HOSTS="2 3 5 9 17"
+fi
+TRAINING_ROUNDS=900     # NUM_ROUNDS in training_game.h
+TRAINING_PLAYERS=64     # for strong scaling
+PLAYERS_PER_HOST=16     # for weak scaling
+
+if [ ! -s "$OUTPUT" ]; then
+    echo "label,suite,program,protocol,ranks,threads,players,field,rounds,repeat,metric,value" > "$OUTPUT"
+fi
+PROFILE=$(mktemp)
+trap 'rm -f "$PROFILE"' EXIT
+
+# run suite program protocol ranks threads players field rounds command...
+run()
+{
+    local suite=$1 program=$2 protocol=$3 ranks=$4 threads=$5 players=$6 field=$7 rounds=$8
+    shift 8
+    local repeat start end key
+    key="$LABEL,$suite,$program,$protocol,$ranks,$threads,$players,$field,$rounds"
+    for repeat in $(seq 1 "$REPEATS"); do
+        start=$(date +%s.%N)
+        if ! OMP_NUM_THREADS=$threads PROFILE_MPI=csv "$@" > /dev/null 2> "$PROFILE"; then
+            echo "$key: failed" >&2
+            cat "$PROFILE" >&2
+            return
+        fi
+        end=$(date +%s.%N)
+        awk -F, -v key="$key,$repeat" -v start="$start" -v end="$end" -v rounds="$rounds" '
+            /^[0-9]+,/ {
+                if (!($2 in slowest)) { phases[++count] = $2; ranks[$2] = 0 }
+                if ($3 > slowest[$2]) slowest[$2] = $3
+                mpi[$2] += $4
+                ranks[$2]++
+                total[$1] += $3
+            }
+            END {
+                wall = end - start
+                run = wall
+                if (count > 0) { run = 0; for (r in total) if (total[r] > run) run = total[r] }
+                printf "%s,wall_s,%.4f\n", key, wall
+                printf "%s,run_s,%.4f\n", key, run
+                printf "%s,rounds_per_s,%.1f\n", key, rounds / run
+                for (p = 1; p <= count; p++)
+                {
+                    printf "%s,phase_%s_s,%.4f\n", key, phases[p], slowest[phases[p]]
+                    printf "%s,phase_%s_mpi_s,%.4f\n", key, phases[p], mpi[phases[p]] / ranks[phases[p]]
+                }
+            }' "$PROFILE" >> "$OUTPUT"
+        echo "$key,$repeat: $(grep "^$key,$repeat,rounds_per_s," "$OUTPUT" | tail -n 1 | cut -d, -f12) rounds/s"
+    done
+}
+
+MATCH="$BUILD/match_mpi"
+ROUNDS=$((2 * HALF))
+
+# strong: the default match on more ranks, field ranks or threads
+for r in $HOSTED; do
+    run strong match_mpi hosted "$r" 1 22 96x128 $ROUNDS $MPIRUN -n "$r" "$MATCH" -p hosted -o none -N $HALF
+done
+for grid in $GRIDS; do
+    cells=$(( ${grid%x*} * ${grid#*x} ))
+    for protocol in cart fused; do
+        run strong match_mpi $protocol $((cells + 22)) 1 22 96x128 $ROUNDS \
+            $MPIRUN -n $((cells + 22)) "$MATCH" -p $protocol -o none -N $HALF -G "$grid"
+    done
+done
+for t in $THREADS; do
+    run strong match_smp smp 1 "$t" 22 96x128 $ROUNDS "$BUILD/match_smp" -o none -N $HALF
+done
+
+# weak: a team of 11 per rank or thread
+for r in $HOSTED; do
+    run weak match_mpi hosted "$r" 1 $((22 * r)) 96x128 $ROUNDS \
+        $MPIRUN -n "$r" "$MATCH" -p hosted -o none -N $HALF -T $((11 * r))
+done
+for t in $THREADS; do
+    run weak match_smp smp 1 "$t" $((22 * t)) 96x128 $ROUNDS "$BUILD/match_smp" -o none -N $HALF -T $((11 * t))
+done
+
+# field: the default grid of field ranks over a larger field
+for field in $FIELDS; do
+    for protocol in cart fused; do
+        run field match_mpi $protocol 34 1 22 "$field" $ROUNDS \
+            $MPIRUN -n 34 "$MATCH" -p $protocol -o none -N $HALF -W "${field%x*}" -L "${field#*x}"
+    done
+done
+
+# training: the field rank and player ranks, -n players over ranks - 1 hosts
+for r in $HOSTS; do
+    run strong training_mpi mpi "$r" 1 $TRAINING_PLAYERS 64x128 $TRAINING_ROUNDS \
+        $MPIRUN -n "$r" "$BUILD/training_mpi" -o none -n $TRAINING_PLAYERS
+    run weak training_mpi mpi "$r" 1 $((PLAYERS_PER_HOST * (r - 1))) 64x128 $TRAINING_ROUNDS \
+        $MPIRUN -n "$r" "$BUILD/training_mpi" -o none -n $((PLAYERS_PER_HOST * (r - 1)))
+done
+run strong training_smp smp 1 1 $TRAINING_PLAYERS 64x128 $TRAINING_ROUNDS "$BUILD/training_smp" -o none -n $TRAINING_PLAYERS
+
+echo "results in $OUTPUT"
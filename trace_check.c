@@ -0,0 +1,308 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "match_game.h"
+#include "trace_check.h"
+
+#define MIN_CHUNK (1 << 20)     // bytes, smaller chunks are not worth a thread
+#define CHUNKS_PER_THREAD 8     // so one slow chunk does not hold up the rest
+
+typedef struct
+{
+    long start, end;            // the rounds that start in [start, end)
+    long count;                 // rounds read
+    trace_round first;          // checked against the chunk before when merging
+    trace_round last;
+    trace_totals totals;
+} trace_chunk;
+
+int readLine(const char* data, long size, long* at, int values[], int max);
+long findRound(const char* data, long size, long at);
+int readRound(const char* data, long size, long* at, trace_format* format, int numPlayers, trace_round* round);
+void checkChunk(const char* data, trace_chunk* chunk, trace_format* format, int numPlayers);
+void copyRound(trace_round* to, trace_round* from, int ints);
+void mergeTotals(trace_totals* into, trace_totals* from, int numPlayers);
+void printViolations(const char* path, const char* data, trace_totals* totals);
+int compareViolations(const void* a, const void* b);
+
+// Checks a match or training trace, e.g. ./trace_check match.lab.o
+// The file is mapped and cut into chunks that start on round boundaries;
+// threads check the chunks and the rounds where chunks meet are checked
+// when the chunks are merged. Per-player statistics go to stdout, the
+// violations and a summary to stderr.
+int main(int argc, char **argv)
+{
+    int opt, c, numPlayers = 0, fields, header[2];
+    int quiet = FALSE;
+    int threads = 1;
+    long at = 0, size;
+    struct stat info;
+    trace_format* format;
+
+    while ((opt = getopt(argc, argv, "q" CONFIG_OPTIONS)) != -1)
+    {
+        if (opt == 'q') quiet = TRUE;
+        else if (!parseConfigOption(opt, optarg)) optind = argc + 1;
+    }
+    const char* error = finishConfig();
+    if (optind != argc - 1 || error != NULL)
+    {
+        if (error != NULL) fprintf(stderr, "%s: %s\n", argv[0], error);
+        fprintf(stderr, "Usage: %s [-q] " CONFIG_USAGE " trace\n", argv[0]);
+        return 1;
+    }
+
+    char* path = argv[optind];
+    int file = open(path, O_RDONLY);
+    if (file < 0 || fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        fprintf(stderr, "%s: cannot read the trace\n", path);
+        return 1;
+    }
+    size = info.st_size;
+    const char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        fprintf(stderr, "%s: cannot map the trace\n", path);
+        return 1;
+    }
+    madvise((void*) data, size, MADV_SEQUENTIAL);
+
+    // the first round tells the game and the number of players
+    readLine(data, size, &at, header, 1);
+    readLine(data, size, &at, header, 2);
+    fields = readLine(data, size, &at, header, 0);
+    for (numPlayers = 1; at < size && readLine(data, size, &at, header, 0) == fields; numPlayers++);
+    if (fields == matchTrace.fields) format = &matchTrace;
+    else if (fields == trainingTrace.fields) format = &trainingTrace;
+    else
+    {
+        fprintf(stderr, "%s: neither a match nor a training trace\n", path);
+        return 1;
+    }
+
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    int numChunks = threads * CHUNKS_PER_THREAD;
+    if (numChunks > size / MIN_CHUNK) numChunks = size / MIN_CHUNK;
+    if (numChunks < 1) numChunks = 1;
+
+    trace_chunk* chunks = calloc(numChunks, sizeof(trace_chunk));
+    for (c = 0; c < numChunks; c++)
+    {
+        chunks[c].start = findRound(data, size, size * c / numChunks);
+        chunks[c].first.values = malloc(numPlayers * fields * sizeof(int));
+        chunks[c].last.values = malloc(numPlayers * fields * sizeof(int));
+        chunks[c].totals.stats = calloc(numPlayers, sizeof(player_stats));
+    }
+    for (c = 0; c < numChunks; c++) chunks[c].end = (c + 1 < numChunks) ? chunks[c + 1].start : size;
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (c = 0; c < numChunks; c++)
+    {
+        checkChunk(data, &chunks[c], format, numPlayers);
+    }
+
+    // the first round of every chunk follows the last round of the one before
+    trace_totals totals;
+    trace_round* before = NULL;
+    memset(&totals, 0, sizeof(totals));
+    totals.stats = calloc(numPlayers, sizeof(player_stats));
+    for (c = 0; c < numChunks; c++)
+    {
+        if (chunks[c].count > 0)
+        {
+            format->check(before, &chunks[c].first, numPlayers, &chunks[c].totals);
+            before = &chunks[c].last;
+        }
+        mergeTotals(&totals, &chunks[c].totals, numPlayers);
+    }
+
+    if (!quiet) format->printStats(totals.stats, numPlayers);
+    printViolations(path, data, &totals);
+    fprintf(stderr, "%s: %s trace, %d players, %ld rounds, %ld violations\n",
+        path, format->name, numPlayers, totals.rounds, totals.violations);
+
+    for (c = 0; c < numChunks; c++)
+    {
+        free(chunks[c].first.values);
+        free(chunks[c].last.values);
+        free(chunks[c].totals.stats);
+    }
+    free(chunks);
+    free(totals.stats);
+    munmap((void*) data, size);
+    return totals.violations > 0;
+}
+
+// Reads up to max ints from the line at *at and moves *at past it.
+// Returns how many ints the line held, or -1 if it holds anything else.
+int readLine(const char* data, long size, long* at, int values[], int max)
+{
+    long i = *at;
+    int count = 0;
+    while (i < size && data[i] != '\n')
+    {
+        int value = 0;
+        int negative = (data[i] == '-');
+        if (data[i] == ' ')
+        {
+            i++;
+            continue;
+        }
+        if (negative) i++;
+        if (i >= size || data[i] < '0' || data[i] > '9')
+        {
+            count = -1;
+            break;
+        }
+        while (i < size && data[i] >= '0' && data[i] <= '9') value = value * 10 + (data[i++] - '0');
+        if (count < max) values[count] = negative ? -value : value;
+        count++;
+    }
+    while (i < size && data[i] != '\n') i++;
+    *at = i + 1;
+    return count;
+}
+
+// Start of the first round at or after at. A round starts with a line
+// holding one int and then one holding two, which no player line does.
+long findRound(const char* data, long size, long at)
+{
+    int values[2];
+    while (at > 0 && at < size && data[at - 1] != '\n') at++;
+    while (at < size)
+    {
+        long next = at;
+        if (readLine(data, size, &next, values, 2) == 1)
+        {
+            long after = next;
+            if (readLine(data, size, &after, values, 2) == 2) return at;
+        }
+        at = next;
+    }
+    return size;
+}
+
+int readRound(const char* data, long size, long* at, trace_format* format, int numPlayers, trace_round* round)
+{
+    int p, ball[2];
+    round->offset = *at;
+    if (readLine(data, size, at, &round->round, 1) != 1) return FALSE;
+    if (readLine(data, size, at, ball, 2) != 2) return FALSE;
+    round->ballX = ball[0];
+    round->ballY = ball[1];
+    for (p = 0; p < numPlayers; p++)
+    {
+        if (readLine(data, size, at, &round->values[p * format->fields], format->fields) != format->fields) return FALSE;
+    }
+    return TRUE;
+}
+
+// Reads the chunk a round at a time, keeping the round before for the
+// checks. The chunk's first round waits for the merge.
+void checkChunk(const char* data, trace_chunk* chunk, trace_format* format, int numPlayers)
+{
+    int ints = numPlayers * format->fields;
+    int current = 0;
+    long at = chunk->start;
+    trace_round rounds[2];
+
+    rounds[0].values = malloc(ints * sizeof(int));
+    rounds[1].values = malloc(ints * sizeof(int));
+    while (at < chunk->end)
+    {
+        trace_round* round = &rounds[current];
+        if (!readRound(data, chunk->end, &at, format, numPlayers, round))
+        {
+            // carry on from the next round, which is checked against the last good one
+            reportViolation(&chunk->totals, round, NO_PLAYER, "malformed round");
+            at = findRound(data, chunk->end, round->offset + 1);
+            continue;
+        }
+        if (chunk->count == 0) copyRound(&chunk->first, round, ints);
+        else format->check(&rounds[1 - current], round, numPlayers, &chunk->totals);
+        chunk->count++;
+        current = 1 - current;
+    }
+    if (chunk->count > 0) copyRound(&chunk->last, &rounds[1 - current], ints);
+    free(rounds[0].values);
+    free(rounds[1].values);
+}
+
+void copyRound(trace_round* to, trace_round* from, int ints)
+{
+    to->round = from->round;
+    to->ballX = from->ballX;
+    to->ballY = from->ballY;
+    to->offset = from->offset;
+    memcpy(to->values, from->values, ints * sizeof(int));
+}
+
+void reportViolation(trace_totals* totals, trace_round* round, int player, const char* what)
+{
+    if (totals->reported < MAX_REPORTED)
+    {
+        trace_violation* violation = &totals->report[totals->reported++];
+        violation->offset = round->offset;
+        violation->player = player;
+        violation->what = what;
+    }
+    totals->violations++;
+}
+
+void mergeTotals(trace_totals* into, trace_totals* from, int numPlayers)
+{
+    int p, v;
+    into->rounds += from->rounds;
+    into->violations += from->violations;
+    for (v = 0; v < from->reported && into->reported < MAX_REPORTED; v++)
+    {
+        into->report[into->reported++] = from->report[v];
+    }
+    for (p = 0; p < numPlayers; p++)
+    {
+        into->stats[p].distance += from->stats[p].distance;
+        into->stats[p].reached += from->stats[p].reached;
+        into->stats[p].kicked += from->stats[p].kicked;
+    }
+}
+
+// Chunks report in the order they are merged, which is trace order, but
+// a chunk's first round is checked last, so sort before counting lines
+void printViolations(const char* path, const char* data, trace_totals* totals)
+{
+    int v;
+    long at = 0, line = 1;
+    qsort(totals->report, totals->reported, sizeof(trace_violation), compareViolations);
+    for (v = 0; v < totals->reported; v++)
+    {
+        trace_violation* violation = &totals->report[v];
+        const char* next;
+        while (at < violation->offset && (next = memchr(data + at, '\n', violation->offset - at)) != NULL)
+        {
+            at = next - data + 1;
+            line++;
+        }
+        if (violation->player == NO_PLAYER) fprintf(stderr, "%s:%ld: %s\n", path, line, violation->what);
+        else fprintf(stderr, "%s:%ld: player %d %s\n", path, line + 2 + violation->player, violation->player, violation->what);
+    }
+}
+
+int compareViolations(const void* a, const void* b)
+{
+    const trace_violation* first = a;
+    const trace_violation* second = b;
+    if (first->offset != second->offset) return first->offset < second->offset ? -1 : 1;
+    return first->player - second->player;
+}
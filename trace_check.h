@@ -0,0 +1,60 @@
+#ifndef TRACE_CHECK_H
+#define TRACE_CHECK_H
+
+#define MAX_FIELDS 10       // ints on a player line, training has the most
+#define MAX_REPORTED 20     // violations printed with their line
+#define NO_PLAYER -1
+
+// One round as printed: the round, the ball and a line per player
+typedef struct
+{
+    int round;
+    int ballX, ballY;
+    int* values;            // fields ints per player
+    long offset;            // where the round starts in the trace
+} trace_round;
+
+typedef struct
+{
+    long distance;          // sum of |dx| + |dy| over every round
+    long reached;           // rounds that ended on the ball
+    long kicked;
+} player_stats;
+
+typedef struct
+{
+    long offset;            // round the violation was found in
+    int player;             // NO_PLAYER for the round lines
+    const char* what;
+} trace_violation;
+
+// What a stretch of the trace added up to. Chunks are checked on their
+// own and merged in order.
+typedef struct
+{
+    long rounds;
+    long violations;
+    int reported;
+    trace_violation report[MAX_REPORTED];
+    player_stats* stats;
+} trace_totals;
+
+// Checks cur against the round before it, or against the kick-off when
+// prev is NULL, and adds cur to the totals. Every round is checked once.
+typedef void (*round_check)(trace_round* prev, trace_round* cur, int numPlayers, trace_totals* totals);
+
+typedef struct
+{
+    const char* name;
+    int fields;
+    round_check check;
+    void (*printStats)(player_stats stats[], int numPlayers);
+} trace_format;
+
+void reportViolation(trace_totals* totals, trace_round* round, int player, const char* what);
+
+// formats, one per game so their types do not meet
+extern trace_format matchTrace;
+extern trace_format trainingTrace;
+
+#endif
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binary_trace.h"
+
+// Prints a binary trace as the text trace the same run prints with
+// -o text, e.g. ./match_mpi -o binary > match.bin; ./trace_text match.bin
+// Reads stdin without a file.
+int main(int argc, char **argv)
+{
+    int round, ballX, ballY, result;
+    binary_trace trace;
+    FILE* file = stdin;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "Usage: %s [binary trace]\n", argv[0]);
+        return 1;
+    }
+    if (argc == 2 && (file = fopen(argv[1], "rb")) == NULL)
+    {
+        fprintf(stderr, "%s: cannot read the trace\n", argv[1]);
+        return 1;
+    }
+    const char* path = argc == 2 ? argv[1] : "stdin";
+    const char* error = openTraceReader(&trace, file);
+    if (error != NULL)
+    {
+        fprintf(stderr, "%s: %s\n", path, error);
+        return 1;
+    }
+
+    static char buffer[1 << 16];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+    int* values = malloc(trace.numPlayers * trace.layout->fields * sizeof(int));
+    while ((result = readTraceRound(&trace, &round, &ballX, &ballY, values)) == TRACE_ROUND)
+    {
+        printTraceRound(stdout, trace.layout, trace.numPlayers, round, ballX, ballY, values);
+    }
+    if (result == TRACE_DAMAGED) fprintf(stderr, "%s: damaged at byte %ld, after %ld rounds\n", path, trace.offset, trace.rounds);
+
+    closeTrace(&trace);
+    free(values);
+    if (file != stdin) fclose(file);
+    return result == TRACE_DAMAGED;
+}
@@ -0,0 +1,123 @@
+#include <stdlib.h>
+
+#include "trace_writer.h"
+
+static void writeSlot(trace_writer* writer, trace_slot* slot)
+{
+    if (writer->binary != NULL) writeTraceRound(writer->binary, slot->round, slot->ballX, slot->ballY, slot->values);
+    else printTraceRound(writer->file, writer->layout, writer->numPlayers, slot->round, slot->ballX, slot->ballY, slot->values);
+}
+
+static void* writeRounds(void* arg)
+{
+    trace_writer* writer = arg;
+    pthread_mutex_lock(&writer->lock);
+    for (;;)
+    {
+        while (writer->written == writer->committed && !writer->stopping) pthread_cond_wait(&writer->filled, &writer->lock);
+        if (writer->written == writer->committed) break;
+
+        // the slot is ours until written moves past it
+        trace_slot* slot = &writer->slots[writer->written % WRITER_SLOTS];
+        pthread_mutex_unlock(&writer->lock);
+        writeSlot(writer, slot);
+        pthread_mutex_lock(&writer->lock);
+        writer->written++;
+        pthread_cond_signal(&writer->drained);
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+void startTraceWriter(trace_writer* writer, FILE* file, const trace_layout* layout, int numPlayers, int binary, int threaded)
+{
+    int s;
+    writer->file = file;
+    writer->layout = layout;
+    writer->numPlayers = numPlayers;
+    writer->committed = 0;
+    writer->written = 0;
+    writer->stopping = 0;
+    writer->binary = NULL;
+    if (binary)
+    {
+        writer->binary = malloc(sizeof(binary_trace));
+        openTraceWriter(writer->binary, file, layout, numPlayers);
+    }
+
+    // without a thread every round goes through the first slot
+    writer->threaded = threaded;
+    for (s = 0; s < (threaded ? WRITER_SLOTS : 1); s++)
+    {
+        writer->slots[s].values = malloc(numPlayers * layout->fields * sizeof(int));
+    }
+    if (!threaded) return;
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->filled, NULL);
+    pthread_cond_init(&writer->drained, NULL);
+    if (pthread_create(&writer->thread, NULL, writeRounds, writer) != 0)
+    {
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->filled);
+        pthread_cond_destroy(&writer->drained);
+        for (s = 1; s < WRITER_SLOTS; s++) free(writer->slots[s].values);
+        writer->threaded = 0;
+    }
+}
+
+trace_slot* nextTraceSlot(trace_writer* writer)
+{
+    if (!writer->threaded) return &writer->slots[0];
+    pthread_mutex_lock(&writer->lock);
+    while (writer->committed - writer->written == WRITER_SLOTS) pthread_cond_wait(&writer->drained, &writer->lock);
+    pthread_mutex_unlock(&writer->lock);
+    return &writer->slots[writer->committed % WRITER_SLOTS];
+}
+
+void commitTraceSlot(trace_writer* writer)
+{
+    if (!writer->threaded)
+    {
+        writeSlot(writer, &writer->slots[0]);
+        return;
+    }
+    pthread_mutex_lock(&writer->lock);
+    writer->committed++;
+    pthread_cond_signal(&writer->filled);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+void syncTraceWriter(trace_writer* writer)
+{
+    if (writer->threaded)
+    {
+        pthread_mutex_lock(&writer->lock);
+        while (writer->written < writer->committed) pthread_cond_wait(&writer->drained, &writer->lock);
+        pthread_mutex_unlock(&writer->lock);
+    }
+    fflush(writer->file);
+}
+
+void stopTraceWriter(trace_writer* writer)
+{
+    int s;
+    if (writer->threaded)
+    {
+        pthread_mutex_lock(&writer->lock);
+        writer->stopping = 1;
+        pthread_cond_signal(&writer->filled);
+        pthread_mutex_unlock(&writer->lock);
+        pthread_join(writer->thread, NULL);
+        pthread_mutex_destroy(&writer->lock);
+        pthread_cond_destroy(&writer->filled);
+        pthread_cond_destroy(&writer->drained);
+    }
+    for (s = 0; s < (writer->threaded ? WRITER_SLOTS : 1); s++) free(writer->slots[s].values);
+    if (writer->binary != NULL)
+    {
+        closeTrace(writer->binary);
+        free(writer->binary);
+    }
+    fflush(writer->file);
+}
@@ -0,0 +1,50 @@
+#ifndef TRACE_WRITER_H
+#define TRACE_WRITER_H
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "binary_trace.h"
+
+#define WRITER_SLOTS 64     // rounds the simulation can get ahead of the file
+
+// One round as the trace shows it
+typedef struct
+{
+    int round;
+    int ballX, ballY;
+    int* values;            // player lines, layout->fields ints each
+} trace_slot;
+
+// Rounds pass through a ring of snapshots to a thread that formats and
+// writes them, so a slow stdout only holds up the reporting rank once the
+// ring is full. The thread makes no MPI calls. Without a thread a round is
+// written as soon as it is committed.
+typedef struct
+{
+    FILE* file;
+    const trace_layout* layout;
+    int numPlayers;
+    binary_trace* binary;       // NULL for text
+    int threaded;
+    trace_slot slots[WRITER_SLOTS];
+    long committed, written;    // rounds so far
+    int stopping;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t filled, drained;
+} trace_writer;
+
+void startTraceWriter(trace_writer* writer, FILE* file, const trace_layout* layout, int numPlayers, int binary, int threaded);
+
+// the slot for the next round, waits while the ring is full
+trace_slot* nextTraceSlot(trace_writer* writer);
+void commitTraceSlot(trace_writer* writer);
+
+// waits until every committed round is in the file, e.g. before a checkpoint
+void syncTraceWriter(trace_writer* writer);
+
+// writes what is left, the file stays open
+void stopTraceWriter(trace_writer* writer);
+
+#endif
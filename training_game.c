@@ -0,0 +1,130 @@
+#include <string.h>
+
+#include "training_game.h"
+
+void initialize(football_player* player, rand_stream* rng, int id) 
+{
+    player->id = id;
+    player->initial.x = drawRandom(rng, DRAW_X) % LENGTH;
+    player->initial.y = drawRandom(rng, DRAW_Y) % WIDTH;
+    player->final.x = player->initial.x;
+    player->final.y = player->initial.y;
+    player->ran = 0;
+    player->reached = 0;
+    player->kicked = 0;
+}
+
+// the libc stream for seed s is s * (num_p + 1) + id modulo 2^32, counter-based
+// streams are keyed on the id
+void seed_entity(rand_stream* rng, int rng_mode, int seed, int id, int num_p)
+{
+    if (rng_mode == RNG_PHILOX) seedCounter(rng, seed, id);
+    else seedRandom(rng, (unsigned int) seed * (unsigned int) (num_p + 1) + (unsigned int) id);
+}
+
+// players set off from where they ended the last round
+void start_round(football_player players[], int count)
+{
+    int p;
+    for (p = 0; p < count; p++)
+    {
+        players[p].initial.x = players[p].final.x;
+        players[p].initial.y = players[p].final.y;
+    }
+}
+
+// Moves a block of players towards the ball. x takes up to 10 steps and y
+// whatever is left, written with min/max instead of branches so the loop
+// vectorises.
+void move_players(football_player players[], int count, pos ball) 
+{
+    int p;
+    #pragma omp simd
+    for (p = 0; p < count; p++)
+    {
+        int dx = ball.x - players[p].initial.x;
+        dx = dx < -10 ? -10 : (dx > 10 ? 10 : dx);
+        int moves_left = 10 - (dx < 0 ? -dx : dx);
+        int dy = ball.y - players[p].initial.y;
+        dy = dy < -moves_left ? -moves_left : (dy > moves_left ? moves_left : dy);
+
+        players[p].final.x = players[p].initial.x + dx;
+        players[p].final.y = players[p].initial.y + dy;
+
+        // increment dist ran
+        players[p].ran += 10 - moves_left + (dy < 0 ? -dy : dy);
+        // increment reached
+        players[p].reached += (players[p].final.x == ball.x) & (players[p].final.y == ball.y);
+    }
+}
+
+void determine_kicker(int* kicker, int reached[], unsigned char reached_set[], int* numReached, int num_p, football_player players[], pos ball, rand_stream* rng) 
+{
+    int i;
+    memset(reached_set, 0, (num_p + 7) / 8);
+    for (i = 0; i < num_p; i++)
+    {
+        // find out all the players that reached the ball
+        if (players[i].final.x == ball.x && players[i].final.y == ball.y) 
+        {
+            reached[*numReached] = i;
+            reached_set[i / 8] |= 1 << (i % 8);
+            (*numReached)++;
+        }
+    }
+
+    if (*numReached != 0) 
+    {
+        // randomly select the kicker
+        *kicker = reached[drawRandom(rng, DRAW_KICKER) % *numReached];
+    } 
+    else 
+    {
+        // no kicker
+        *kicker = -1;
+    }
+
+}
+
+
+int has_reached(int id, const unsigned char reached_set[]) 
+{
+    return (reached_set[id / 8] >> (id % 8)) & 1;
+}
+
+// counter-based draws are keyed on round + 1, round 0 is the set-up
+void kick_ball(pos* ball, rand_stream* rng, int round)
+{
+    setRandomRound(rng, round + 1);
+    ball->x = drawRandom(rng, DRAW_X) % LENGTH;
+    ball->y = drawRandom(rng, DRAW_Y) % WIDTH;
+}
+
+// the fields of a trace line, see trainingLayout in binary_trace.c
+void player_line(football_player player, int has_reached, int has_kicked, int values[])
+{
+    values[0] = player.id;
+    values[1] = player.initial.x;
+    values[2] = player.initial.y;
+    values[3] = player.final.x;
+    values[4] = player.final.y;
+    values[5] = has_reached;
+    values[6] = has_kicked;
+    values[7] = player.ran;
+    values[8] = player.reached;
+    values[9] = player.kicked;
+}
+
+int idle_rounds(football_player players[], int count, pos ball)
+{
+    int p;
+    int first = -1;         // rounds until the first player gets there
+    for (p = 0; p < count; p++)
+    {
+        int dx = ball.x - players[p].final.x;
+        int dy = ball.y - players[p].final.y;
+        int rounds = ((dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy) + 9) / 10;
+        if (first < 0 || rounds < first) first = rounds;
+    }
+    return first > 1 ? first - 1 : 0;
+}
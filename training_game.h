@@ -0,0 +1,42 @@
+#ifndef TRAINING_GAME_H
+#define TRAINING_GAME_H
+
+#include "rng.h"
+
+#define WIDTH 64
+#define LENGTH 128
+#define NUM_ROUNDS 900
+
+typedef struct
+{
+    int x;
+    int y;
+} pos;
+
+typedef struct
+{
+    int id;         // player id
+    pos initial;    // initial pos 
+    pos final;      // final pos
+    int ran;        // distance ran
+    int reached;    // no. of times reached the ball
+    int kicked;     // no. of times kicked the ball
+} football_player;
+
+// training rules, kept apart from the MPI driver so they can be
+// benchmarked on their own
+void initialize(football_player* player, rand_stream* rng, int id);
+void seed_entity(rand_stream* rng, int rng_mode, int seed, int id, int num_p);
+void start_round(football_player players[], int count);
+void move_players(football_player players[], int count, pos ball);
+void determine_kicker(int* kicker, int reached[], unsigned char reached_set[], int* numReached, int num_p, football_player players[], pos ball, rand_stream* rng);
+int has_reached(int id, const unsigned char reached_set[]);
+void kick_ball(pos* ball, rand_stream* rng, int round);
+void player_line(football_player player, int has_reached, int has_kicked, int values[]);
+
+// Rounds from the next one on in which nobody can reach a ball that stays
+// put. A player runs 10 a round straight at it, so a player d away first
+// stands on it ceil(d / 10) rounds later.
+int idle_rounds(football_player players[], int count, pos ball);
+
+#endif
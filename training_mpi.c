@@ -2,184 +2,361 @@
 #include <stdio.h>
 #include <time.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mpi_profile.h"
+#include "parallel_trace.h"
+#include "trace_writer.h"
+#include "training_game.h"
 
-#define WIDTH 64
-#define LENGTH 128
-#define NUM_ROUNDS 900
-#define COUNT_1 1
 #define DEBUG 0
 
+#define CHECKPOINT_MAGIC "TRAINCK1"
+
+// profiling phases, see mpi_profile.h
+#define PHASE_SETUP 0
+#define PHASE_MOVE 1
+#define PHASE_GATHER 2
+#define PHASE_KICKER 3
+#define PHASE_KICK 4        // announcing the kicker, the new ball and the idle rounds
+#define PHASE_PRINT 5
+#define PHASE_CHECKPOINT 6
+#define NUM_PHASES 7
+
+// Players are spread in contiguous blocks over every rank except the field
 typedef struct
 {
-    int x;
-    int y;
-} pos;
-
+    int num_players;
+    int num_hosts;
+    int first;      // first player hosted by this rank
+    int count;      // number of players hosted by this rank
+} player_layout;
+
+// A checkpoint is this header, every player, every player's stream and
+// then the field's stream. Streams are per player id, so a run can resume
+// on a different number of ranks.
 typedef struct
 {
-    int id;         // player id
-    pos initial;    // initial pos 
-    pos final;      // final pos
-    int ran;        // distance ran
-    int reached;    // no. of times reached the ball
-    int kicked;     // no. of times kicked the ball
-} football_player;
+    char magic[8];
+    int num_p;
+    int seed;
+    int rng_mode;
+    int round;      // next round to play
+    pos ball;
+} training_checkpoint;
 
 int field, tag;
 
-void initialize(pos* ball, football_player* player, int rank);
-void print_player_data(football_player player, int has_reached, int has_kicked);
+void report_round(trace_writer* writer, int round, pos ball, football_player players[], int num_p, unsigned char reached_set[], int kicker);
+void report_part(parallel_trace* trace, int world_rank, int round, pos ball, football_player players[], int count, int kicker);
 void createBallStruct(MPI_Datatype* mpi_ball);
 void createPlayerStruct(MPI_Datatype mpi_ball, MPI_Datatype* mpi_player);
-void move_player(football_player* player, pos ball);
-void determine_kicker(int* kicker, int reached[], int* numReached, int num_p, football_player players[], pos ball);
+void parse_options(int argc, char **argv, int world_rank, int* num_p, int* seed, int* rng_mode, int* every, char** checkpoint, char** restart, int* output, char** trace_path);
+void layout_players(player_layout* layout, int num_p, int num_hosts, int rank);
 
-int has_reached(int id, int reached[], int numReached);
+void save_training(char* path, training_checkpoint* header, football_player players[], rand_stream rngs[]);
+void restore_training(char* path, training_checkpoint* header, int world_rank, player_layout* layout, football_player players[], rand_stream rngs[], int counts[], int displs[], MPI_Datatype mpi_player);
 
 
 
 int main(int argc, char **argv)
 {
     int world_size, world_rank;
-    MPI_Init(NULL, NULL);
+    int provided;
+    // only the main thread makes MPI calls, the trace writer makes none
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_size(MPI_COMM_WORLD, &world_size);
     MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    const char* phase_names[NUM_PHASES] = {"setup", "move", "gather", "kicker", "kick", "print", "checkpoint"};
+    profilePhases(phase_names, NUM_PHASES);
 
     int round, p, kicker;
     int num_p = world_size - 1;
+    int seed = 0;
+    int rng_mode = RNG_LIBC;
+    int every = 0;              // checkpoint interval in rounds, 0 for none
+    char* checkpoint = "training.ckpt";
+    char* restart = NULL;
+    int first_round = 0;
+    int idle = 0;               // rounds left in which nobody can reach the ball
+    int output = OUTPUT_TEXT;   // see binary_trace.h
+    trace_writer* writer = NULL;
+    char* trace_path = NULL;    // every rank writes its part there with MPI-IO
+    parallel_trace* parallel = NULL;
+    pos start_ball;             // the ball a round is reported with
+    if (world_size < 2)
+    {
+        fprintf(stderr, "Need at least one player rank besides the field\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    parse_options(argc, argv, world_rank, &num_p, &seed, &rng_mode, &every, &checkpoint, &restart, &output, &trace_path);
 
     field = world_size - 1;
     tag = 0;
 
+    player_layout layout;
+    layout_players(&layout, num_p, world_size - 1, world_rank);
+
     // create a type for struct ball
     pos ball;
     MPI_Datatype mpi_ball;
     createBallStruct(&mpi_ball);
 
     // create a type for struct players
-    football_player player;
     MPI_Datatype mpi_player;
     createPlayerStruct(mpi_ball, &mpi_player);
 
-    srand(world_rank);
-
-    initialize(&ball, &player, world_rank);
+    // every player has its own stream for its id and the field uses id
+    // num_p, so with seed 0 one player per rank is the original srand(rank).
+    // The field draws every kick, so it keeps every player's stream and
+    // its own last, the way a checkpoint holds them.
+    football_player* players = NULL;
+    rand_stream* rngs = malloc((world_rank == field ? num_p + 1 : layout.count) * sizeof(rand_stream));
+    int* counts = NULL;
+    int* displs = NULL;
+    int* reached = NULL;
+    unsigned char* reached_set = NULL;
+
+    ball.x = LENGTH / 2 ;
+    ball.y = WIDTH / 2 ;
+
+    if (world_rank == field)
+    {
+        players = malloc(num_p * sizeof(football_player));
+        counts = malloc(world_size * sizeof(int));
+        displs = malloc(world_size * sizeof(int));
+        reached = malloc(num_p * sizeof(int));
+        reached_set = calloc((num_p + 7) / 8, 1);
+        if (trace_path == NULL && output != OUTPUT_NONE)
+        {
+            writer = malloc(sizeof(trace_writer));
+            startTraceWriter(writer, stdout, &trainingLayout, num_p, output == OUTPUT_BINARY, provided >= MPI_THREAD_FUNNELED);
+        }
+        for (p = 0; p < num_p; p++)
+        {
+            seed_entity(&rngs[p], rng_mode, seed, p, num_p);
+            initialize(&players[p], &rngs[p], p);
+        }
+        seed_entity(&rngs[num_p], rng_mode, seed, num_p, num_p);
+        for (p = 0; p < world_size; p++)
+        {
+            player_layout host;
+            layout_players(&host, num_p, world_size - 1, p);
+            counts[p] = host.count;
+            displs[p] = host.first;
+        }
+    }
+    else
+    {
+        players = malloc(layout.count * sizeof(football_player));
+        for (p = 0; p < layout.count; p++)
+        {
+            seed_entity(&rngs[p], rng_mode, seed, layout.first + p, num_p);
+            initialize(&players[p], &rngs[p], layout.first + p);
+        }
+    }
 
-    for (round = 0; round < NUM_ROUNDS; round++) {
-        // field process
-        if (world_rank == field)
+    if (trace_path != NULL)
+    {
+        parallel = malloc(sizeof(parallel_trace));
+        const char* error = openParallelTrace(parallel, MPI_COMM_WORLD, trace_path, &trainingLayout);
+        if (error != NULL)
         {
-            football_player players[num_p];     // array for storing player data
+            if (world_rank == field) fprintf(stderr, "%s: %s\n", trace_path, error);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
 
-            // start new round
-            printf("%d\n", round);
-            printf("%d %d\n", ball.x, ball.y);
+    if (restart != NULL)
+    {
+        training_checkpoint header;
+        restore_training(restart, &header, world_rank, &layout, players, rngs, counts, displs, mpi_player);
+        first_round = header.round;
+        ball = header.ball;
+    }
 
-            // Send out new ball position
-            for (p = 0; p < num_p; p++) 
-            {
-                MPI_Send(&ball, COUNT_1, mpi_ball, p, tag, MPI_COMM_WORLD);
-            }
+    for (round = first_round; round < NUM_ROUNDS; round++) {
+        // the trace shows the ball the players run to, not where it is kicked
+        start_ball = ball;
 
-            // Receive final positions
-            for (p = 0; p < num_p; p++)
+        if (idle > 0)
+        {
+            // nobody can reach the ball, so it stays put and every player just
+            // runs at it. Each rank plays the round on its own copy of the players.
+            int count = (world_rank == field) ? num_p : layout.count;
+            PROFILE_PHASE(PHASE_MOVE);
+            start_round(players, count);
+            move_players(players, count, ball);
+            idle--;
+
+            PROFILE_PHASE(PHASE_PRINT);
+            if (parallel != NULL) report_part(parallel, world_rank, round, start_ball, players, layout.count, -1);
+            else if (writer != NULL) report_round(writer, round, start_ball, players, num_p, NULL, -1);
+        }
+        else
+        {
+            if (world_rank != field) // player process
             {
-                MPI_Recv(&players[p], COUNT_1, mpi_player, p, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                // move towards the ball
+                PROFILE_PHASE(PHASE_MOVE);
+                start_round(players, layout.count);
+                move_players(players, layout.count, ball);
             }
 
-            // determine kicker
-            kicker = -1;
-            int numReached = 0;
-            int reached[34];
-            determine_kicker(&kicker, reached, &numReached, num_p, players, ball);
-            if (DEBUG) printf("%d players reached\n", numReached);
+            // collect final positions
+            PROFILE_PHASE(PHASE_GATHER);
+            MPI_Gatherv(world_rank == field ? MPI_IN_PLACE : players, layout.count, mpi_player,
+                players, counts, displs, mpi_player, field, MPI_COMM_WORLD);
 
-            // announce kicker
-            for (p = 0; p < num_p; p++) 
+            // The field determines the kicker and draws the kick with the
+            // kicker's stream, then works out how long nobody can reach
+            // the ball, kicked or not. All of it goes out in one message.
+            int numReached = 0;
+            int announce[4] = {-1, 0, ball.x, ball.y};
+            if (world_rank == field)
             {
-                MPI_Send(&kicker, COUNT_1, MPI_INT, p, tag, MPI_COMM_WORLD);
+                // counter-based draws are keyed on round + 1, round 0 is the set-up
+                PROFILE_PHASE(PHASE_KICKER);
+                setRandomRound(&rngs[num_p], round + 1);
+                determine_kicker(&kicker, reached, reached_set, &numReached, num_p, players, ball, &rngs[num_p]);
+                if (DEBUG) printf("%d players reached\n", numReached);
+                if (kicker >= 0)
+                {
+                    kick_ball(&ball, &rngs[kicker], round);
+                    players[kicker].kicked += 1;
+                    if (DEBUG) printf("Ball kicked by %d to %d, %d\n", kicker, ball.x, ball.y);
+                }
+                announce[0] = kicker;
+                announce[1] = idle_rounds(players, num_p, ball);
+                announce[2] = ball.x;
+                announce[3] = ball.y;
             }
 
-            // Update kicker information
-            if (numReached > 0) {
-                MPI_Recv(&ball, COUNT_1, mpi_ball, kicker, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-                MPI_Recv(&players[kicker], COUNT_1, mpi_player, kicker, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            } 
+            PROFILE_PHASE(PHASE_KICK);
+            MPI_Bcast(announce, 4, MPI_INT, field, MPI_COMM_WORLD);
+            kicker = announce[0];
+            idle = announce[1];
+            ball.x = announce[2];
+            ball.y = announce[3];
+            if (kicker >= layout.first && kicker < layout.first + layout.count) players[kicker - layout.first].kicked += 1;
 
-            // Output player results
-            for (p = 0; p < num_p; p++) {
-                print_player_data(players[p], has_reached(p, reached, numReached), kicker == p ? 1 : 0);
+            if (world_rank == field)
+            {
+                // Output player results
+                PROFILE_PHASE(PHASE_PRINT);
+                if (writer != NULL) report_round(writer, round, start_ball, players, num_p, reached_set, kicker);
             }
-        }
-        else // player process
-        {
-            // set new initial positions
-            player.initial.x = player.final.x;
-            player.initial.y = player.final.y;
-
-            // receive ball location
-            MPI_Recv(&ball, COUNT_1, mpi_ball, field, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-
-            // move towards the ball
-            move_player(&player, ball);
-            
-            // Send final positions
-            MPI_Send(&player, COUNT_1, mpi_player, field, tag, MPI_COMM_WORLD); 
-
-            // Get kicker
-            MPI_Recv(&kicker, COUNT_1, MPI_INT, field, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-
-            if (player.id == kicker) {
-                // kick to new location
-                ball.x = rand() % LENGTH;
-                ball.y = rand() % WIDTH;
-                player.kicked += 1;
-                if (DEBUG) printf("Ball kicked by %d to %d, %d\n", player.id, ball.x, ball.y);
-                MPI_Send(&ball, COUNT_1, mpi_ball, field, tag, MPI_COMM_WORLD);
-                MPI_Send(&player, COUNT_1, mpi_player, field, tag, MPI_COMM_WORLD); 
+            if (parallel != NULL)
+            {
+                PROFILE_PHASE(PHASE_PRINT);
+                report_part(parallel, world_rank, round, start_ball, players, layout.count, kicker);
             }
         }
 
-        MPI_Barrier(MPI_COMM_WORLD);
+        if (every > 0 && (round + 1) % every == 0 && round + 1 < NUM_ROUNDS)
+        {
+            training_checkpoint header = {CHECKPOINT_MAGIC, num_p, seed, rng_mode, round + 1, ball};
+            PROFILE_PHASE(PHASE_CHECKPOINT);
+            // the trace on disk has to reach the checkpoint
+            if (writer != NULL) syncTraceWriter(writer);
+            if (parallel != NULL) flushParallelTrace(parallel);
+            if (world_rank == field) save_training(checkpoint, &header, players, rngs);
+        }
     }
 
+    if (writer != NULL) stopTraceWriter(writer);
+    if (parallel != NULL) closeParallelTrace(parallel);
+    free(writer);
+    free(parallel);
+    free(players);
+    free(rngs);
+    free(counts);
+    free(displs);
+    free(reached);
+    free(reached_set);
+
     // Finalize the MPI environment.
     MPI_Finalize();
 }
 
-void initialize(pos* ball, football_player* player, int rank) 
+void parse_options(int argc, char **argv, int world_rank, int* num_p, int* seed, int* rng_mode, int* every, char** checkpoint, char** restart, int* output, char** trace_path)
 {
-    if (rank == field) 
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:R:k:f:x:o:w:")) != -1)
     {
-        // ball starts in the middle
-        ball->x = LENGTH / 2 ;
-        ball->y = WIDTH / 2 ;
+        if (opt == 'n' && atoi(optarg) > 0) *num_p = atoi(optarg);
+        else if (opt == 's') *seed = atoi(optarg);
+        else if (opt == 'k') *every = atoi(optarg);
+        else if (opt == 'f') *checkpoint = optarg;
+        else if (opt == 'x') *restart = optarg;
+        else if (opt == 'R' && strcmp(optarg, "libc") == 0) *rng_mode = RNG_LIBC;
+        else if (opt == 'R' && strcmp(optarg, "philox") == 0) *rng_mode = RNG_PHILOX;
+        else if (opt == 'o' && strcmp(optarg, "text") == 0) *output = OUTPUT_TEXT;
+        else if (opt == 'o' && strcmp(optarg, "binary") == 0) *output = OUTPUT_BINARY;
+        else if (opt == 'o' && strcmp(optarg, "none") == 0) *output = OUTPUT_NONE;
+        else if (opt == 'w') *trace_path = optarg;
+        else
+        {
+            if (world_rank == 0) fprintf(stderr, "Usage: %s [-n players] [-s seed] [-R libc|philox] [-k checkpoint every] [-f checkpoint] [-x restart from] [-o text|binary|none] [-w trace file]\n", argv[0]);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
     }
-    else // initialize player
+    if (*output != OUTPUT_TEXT && *trace_path != NULL)
     {
-        player->id = rank;
-        player->initial.x = rand() % LENGTH;
-        player->initial.y = rand() % WIDTH;
-        player->final.x = player->initial.x;
-        player->final.y = player->initial.y;
-        player->ran = 0;
-        player->reached = 0;
-        player->kicked = 0;
+        if (world_rank == 0) fprintf(stderr, "%s: %s, leave out -w\n", argv[0], *output == OUTPUT_BINARY ?
+            "binary traces are written by the field alone" : "-o none writes no trace");
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
 }
 
+void layout_players(player_layout* layout, int num_p, int num_hosts, int rank)
+{
+    int base = num_p / num_hosts;
+    int extra = num_p % num_hosts;
+    layout->num_players = num_p;
+    layout->num_hosts = num_hosts;
+    if (rank >= num_hosts)
+    {
+        // the field hosts no players
+        layout->first = num_p;
+        layout->count = 0;
+        return;
+    }
+    layout->first = rank * base + (rank < extra ? rank : extra);
+    layout->count = base + (rank < extra ? 1 : 0);
+}
+
+// Hands the round to the trace writer, which prints it while the next
+// is played. A NULL reached_set is a round in which nobody reached the ball.
+void report_round(trace_writer* writer, int round, pos ball, football_player players[], int num_p, unsigned char reached_set[], int kicker)
+{
+    int p;
+    trace_slot* snapshot = nextTraceSlot(writer);
+    snapshot->round = round;
+    snapshot->ballX = ball.x;
+    snapshot->ballY = ball.y;
+    for (p = 0; p < num_p; p++)
+    {
+        int reached = reached_set == NULL ? 0 : has_reached(p, reached_set);
+        player_line(players[p], reached, kicker == p ? 1 : 0, &snapshot->values[p * trainingLayout.fields]);
+    }
+    commitTraceSlot(writer);
+}
 
-void print_player_data(football_player player, int has_reached, int has_kicked) 
+// With -w the field adds the header and every other rank the lines of its
+// own block. A player reached the ball if it ended the round on it.
+void report_part(parallel_trace* trace, int world_rank, int round, pos ball, football_player players[], int count, int kicker)
 {
-    printf("%d ", player.id);
-    printf("%d %d ", player.initial.x, player.initial.y);
-    printf("%d %d ", player.final.x, player.final.y);
-    printf("%d ", has_reached);
-    printf("%d ", has_kicked);
-    printf("%d ", player.ran);
-    printf("%d ", player.reached);
-    printf("%d ", player.kicked);
-    printf("\n");
+    int p, values[MAX_TRACE_FIELDS];
+    if (world_rank == field) addTraceHeader(trace, round, ball.x, ball.y);
+    for (p = 0; p < count; p++)
+    {
+        int on_ball = players[p].final.x == ball.x && players[p].final.y == ball.y;
+        player_line(players[p], on_ball, players[p].id == kicker ? 1 : 0, values);
+        addTraceLines(trace, values, 1);
+    }
+    endTraceRound(trace);
 }
 
 void createBallStruct(MPI_Datatype* mpi_ball) 
@@ -214,79 +391,46 @@ void createPlayerStruct(MPI_Datatype mpi_ball, MPI_Datatype* mpi_player)
     MPI_Type_commit(mpi_player);
 }
 
-
-void move_player(football_player* player, pos ball) 
+// The field already has every player from this round's gather and every
+// stream, so it writes the checkpoint alone
+void save_training(char* path, training_checkpoint* header, football_player players[], rand_stream rngs[])
 {
-    int moves_left = 10;
-    int movement;
-    int direction;
-    int difference;
-    if (player->initial.x != ball.x && moves_left != 0) {
-        if (player->initial.x > ball.x) {
-            direction = -1;
-            difference = player->initial.x - ball.x;
-        } else {
-            direction = 1;
-            difference = ball.x - player->initial.x;
-        }
-        movement = difference < moves_left ? difference : moves_left;
-        player->final.x = player->initial.x + direction * movement;
-        moves_left -= movement;
-    }
-
-    if (player->initial.y != ball.y && moves_left != 0) {
-        if (player->initial.y > ball.y) {
-            direction = -1;
-            difference = player->initial.y - ball.y;
-        } else {
-            direction = 1;
-            difference = ball.y - player->initial.y;
-        }  
-        movement = difference < moves_left ? difference : moves_left;
-        player->final.y = player->initial.y + direction * movement;
-        moves_left -= movement;
+    // write next to the old checkpoint, then rename over it
+    char temp[4096];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE* file = fopen(temp, "wb");
+    int ok = (file != NULL);
+    ok = ok && fwrite(header, sizeof(*header), 1, file) == 1;
+    ok = ok && fwrite(players, sizeof(football_player), header->num_p, file) == (size_t) header->num_p;
+    ok = ok && fwrite(rngs, sizeof(rand_stream), header->num_p + 1, file) == (size_t) header->num_p + 1;
+    if (file != NULL) ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(temp, path) != 0)
+    {
+        fprintf(stderr, "%s: cannot write the checkpoint\n", path);
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
-
-    // increment dist ran
-    player->ran += 10 - moves_left;
-    // increment reached
-    if (ball.x == player->final.x && ball.y == player->final.y)
-        player->reached += 1;
 }
 
-void determine_kicker(int* kicker, int reached[], int* numReached, int num_p, football_player players[], pos ball) 
+// Only the field draws from the streams, so they stay with it
+void restore_training(char* path, training_checkpoint* header, int world_rank, player_layout* layout, football_player players[], rand_stream rngs[], int counts[], int displs[], MPI_Datatype mpi_player)
 {
-    int i;
-    for (i = 0; i < num_p; i++)
+    if (world_rank == field)
     {
-        // find out all the players that reached the ball
-        if (players[i].final.x == ball.x && players[i].final.y == ball.y) 
+        int num_p = layout->num_players;
+        FILE* file = fopen(path, "rb");
+        int ok = (file != NULL);
+        ok = ok && fread(header, sizeof(*header), 1, file) == 1;
+        ok = ok && memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) == 0 && header->num_p == num_p;
+        ok = ok && fread(players, sizeof(football_player), num_p, file) == (size_t) num_p;
+        ok = ok && fread(rngs, sizeof(rand_stream), num_p + 1, file) == (size_t) num_p + 1;
+        if (file != NULL) fclose(file);
+        if (!ok)
         {
-            reached[*numReached] = i;
-            (*numReached)++;
+            fprintf(stderr, "%s: not a checkpoint of a %d player training\n", path, num_p);
+            MPI_Abort(MPI_COMM_WORLD, 1);
         }
     }
 
-    if (*numReached != 0) 
-    {
-        // randomly select the kicker
-        *kicker = reached[rand() % *numReached];
-    } 
-    else 
-    {
-        // no kicker
-        *kicker = -1;
-    }
-
-}
-
-
-int has_reached(int id, int reached[], int numReached) 
-{
-    int i;
-    for (i = 0; i < numReached; i++)
-    {
-        if (reached[i] == id) return 1;
-    }
-    return 0;
+    MPI_Bcast(header, sizeof(*header), MPI_BYTE, field, MPI_COMM_WORLD);
+    MPI_Scatterv(players, counts, displs, mpi_player, world_rank == field ? MPI_IN_PLACE : players, layout->count, mpi_player, field, MPI_COMM_WORLD);
 }
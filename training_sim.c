@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "training_sim.h"
+
+void init_training(training_sim* sim, int num_p, int seed, int rng_mode)
+{
+    int p;
+    sim->num_p = num_p;
+    sim->round = 0;
+    sim->idle = 0;
+    sim->ball.x = LENGTH / 2;
+    sim->ball.y = WIDTH / 2;
+    sim->start_ball = sim->ball;
+    sim->kicker = -1;
+    sim->players = malloc(num_p * sizeof(football_player));
+    sim->rngs = malloc((num_p + 1) * sizeof(rand_stream));
+    sim->reached = malloc(num_p * sizeof(int));
+    sim->reached_set = calloc((num_p + 7) / 8, 1);
+
+    // the field's stream is id num_p, as in training_mpi
+    for (p = 0; p < num_p; p++)
+    {
+        seed_entity(&sim->rngs[p], rng_mode, seed, p, num_p);
+        initialize(&sim->players[p], &sim->rngs[p], p);
+    }
+    seed_entity(&sim->rngs[num_p], rng_mode, seed, num_p, num_p);
+}
+
+void free_training(training_sim* sim)
+{
+    free(sim->players);
+    free(sim->rngs);
+    free(sim->reached);
+    free(sim->reached_set);
+}
+
+int training_finished(training_sim* sim)
+{
+    return sim->round >= NUM_ROUNDS;
+}
+
+void step_training(training_sim* sim)
+{
+    int num_reached = 0;
+    if (training_finished(sim)) return;
+
+    sim->start_ball = sim->ball;
+    start_round(sim->players, sim->num_p);
+    move_players(sim->players, sim->num_p, sim->ball);
+    if (sim->idle > 0)
+    {
+        // nobody can reach the ball, so there is no kicker to draw
+        sim->idle--;
+        sim->kicker = -1;
+        memset(sim->reached_set, 0, (sim->num_p + 7) / 8);
+    }
+    else
+    {
+        rand_stream* field_rng = &sim->rngs[sim->num_p];
+        setRandomRound(field_rng, sim->round + 1);
+        determine_kicker(&sim->kicker, sim->reached, sim->reached_set, &num_reached, sim->num_p, sim->players, sim->ball, field_rng);
+        if (sim->kicker >= 0)
+        {
+            kick_ball(&sim->ball, &sim->rngs[sim->kicker], sim->round);
+            sim->players[sim->kicker].kicked += 1;
+        }
+        // idle_rounds never overestimates, so it holds for a new ball too
+        sim->idle = idle_rounds(sim->players, sim->num_p, sim->ball);
+    }
+    sim->round++;
+}
+
+int run_training(training_sim* sim, int rounds)
+{
+    int played = 0;
+    while (played < rounds && !training_finished(sim))
+    {
+        step_training(sim);
+        played++;
+    }
+    return played;
+}
+
+void snapshot_training(training_sim* sim, training_snapshot* snapshot)
+{
+    snapshot->round = sim->round - 1;
+    snapshot->num_p = sim->num_p;
+    snapshot->players = sim->players;
+    snapshot->reached_set = sim->reached_set;
+    snapshot->ball = sim->start_ball;
+    snapshot->next_ball = sim->ball;
+    snapshot->kicker = sim->kicker;
+}
@@ -0,0 +1,44 @@
+#ifndef TRAINING_SIM_H
+#define TRAINING_SIM_H
+
+#include "training_game.h"
+
+// A whole training in the calling process, played a round at a time with
+// the same streams as training_mpi, so it gives the same trace for the
+// same number of players, seed and generator.
+typedef struct
+{
+    int num_p;
+    int round;                      // next round to play
+    int idle;                       // rounds left in which nobody can reach the ball
+    pos ball;                       // where the players run to next
+    pos start_ball;                 // the ball the last round was played with
+    int kicker;                     // of the last round, -1 for none
+    football_player* players;
+    rand_stream* rngs;              // one per player, then the field's
+    int* reached;
+    unsigned char* reached_set;     // who reached the ball in the last round
+} training_sim;
+
+// Read-only view of the simulation's own buffers, valid until the next step
+typedef struct
+{
+    int round;                      // the round the state is from, -1 before the first
+    int num_p;
+    const football_player* players;
+    const unsigned char* reached_set;   // see has_reached
+    pos ball;                       // the ball the players ran to
+    pos next_ball;                  // where it was kicked, or the same ball
+    int kicker;
+} training_snapshot;
+
+void init_training(training_sim* sim, int num_p, int seed, int rng_mode);
+void free_training(training_sim* sim);
+
+int training_finished(training_sim* sim);
+void step_training(training_sim* sim);
+// plays up to rounds rounds and returns how many were played
+int run_training(training_sim* sim, int rounds);
+void snapshot_training(training_sim* sim, training_snapshot* snapshot);
+
+#endif
@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "binary_trace.h"
+#include "training_sim.h"
+
+// Runs a whole training in one process. The trace is identical to
+// training_mpi with as many players, e.g. ./training_smp -n 11 and
+// mpirun -n 12 training_mpi
+int main(int argc, char **argv)
+{
+    int opt, p;
+    int num_p = 11;
+    int seed = 0;
+    int rng_mode = RNG_LIBC;
+    int output = OUTPUT_TEXT;
+    binary_trace trace;
+    training_sim sim;
+    training_snapshot snapshot;
+
+    while ((opt = getopt(argc, argv, "n:s:R:o:")) != -1)
+    {
+        if (opt == 'n' && atoi(optarg) > 0) num_p = atoi(optarg);
+        else if (opt == 's') seed = atoi(optarg);
+        else if (opt == 'R' && strcmp(optarg, "libc") == 0) rng_mode = RNG_LIBC;
+        else if (opt == 'R' && strcmp(optarg, "philox") == 0) rng_mode = RNG_PHILOX;
+        else if (opt == 'o' && strcmp(optarg, "text") == 0) output = OUTPUT_TEXT;
+        else if (opt == 'o' && strcmp(optarg, "binary") == 0) output = OUTPUT_BINARY;
+        else if (opt == 'o' && strcmp(optarg, "none") == 0) output = OUTPUT_NONE;
+        else
+        {
+            fprintf(stderr, "Usage: %s [-n players] [-s seed] [-R libc|philox] [-o text|binary|none]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    static char buffer[1 << 16];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+    int* values = malloc(num_p * trainingLayout.fields * sizeof(int));
+    if (output == OUTPUT_BINARY) openTraceWriter(&trace, stdout, &trainingLayout, num_p);
+
+    init_training(&sim, num_p, seed, rng_mode);
+    while (!training_finished(&sim))
+    {
+        step_training(&sim);
+        if (output == OUTPUT_NONE) continue;
+
+        snapshot_training(&sim, &snapshot);
+        for (p = 0; p < num_p; p++)
+        {
+            player_line(snapshot.players[p], has_reached(p, snapshot.reached_set),
+                snapshot.kicker == p ? 1 : 0, &values[p * trainingLayout.fields]);
+        }
+        if (output == OUTPUT_BINARY) writeTraceRound(&trace, snapshot.round, snapshot.ball.x, snapshot.ball.y, values);
+        else printTraceRound(stdout, &trainingLayout, num_p, snapshot.round, snapshot.ball.x, snapshot.ball.y, values);
+    }
+
+    if (output == OUTPUT_BINARY) closeTrace(&trace);
+    free_training(&sim);
+    free(values);
+    return 0;
+}